@@ -41,8 +41,17 @@ typedef struct IotConnectHttpRequest {
 
 // supports get and post
 // if post_data is NULL, a get is executed
+// Requests from different threads are serialized, as they share the TLS buffers. Custom handlers run
+// while the request holds the lock. The default response buffer is also shared, so the response of one
+// thread can be overwritten by the request of another once this function returns.
 UINT iotconnect_https_request(IotConnectHttpRequest *request);
 
+// With IOTC_ENABLE_HTTPS_KEEP_ALIVE, the connection of a request without a custom handler is kept open
+// if the server allows it, and reused by the next request to the same host within
+// IOTCONNECT_HTTPS_KEEP_ALIVE_IDLE_S seconds. Only one connection is kept, as the TLS buffers are shared.
+// Closes that connection, if any. Safe to call without IOTC_ENABLE_HTTPS_KEEP_ALIVE.
+void iotconnect_https_close(void);
+
 #ifdef __cplusplus
 }
 #endif
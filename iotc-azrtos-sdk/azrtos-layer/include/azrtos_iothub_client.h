@@ -14,7 +14,26 @@ extern   "C" {
 #include "nx_azure_iot_hub_client.h"
 #include "iotconnect.h"
 
-typedef void (*IotConnectC2dCallback)(UCHAR* message, size_t message_len);
+// Largest number of chained packets an inbound message can span
+#ifndef IOTC_C2D_MAX_SEGMENTS
+#define IOTC_C2D_MAX_SEGMENTS (8)
+#endif
+
+typedef struct {
+    UCHAR *data;
+    size_t len;
+} IotConnectC2dSegment;
+
+// Scatter-gather view of an inbound message. The segments point directly into the chained packets,
+// so the message is not copied. The view is only valid for the duration of the callback.
+typedef struct {
+    IotConnectC2dSegment segments[IOTC_C2D_MAX_SEGMENTS];
+    UINT segment_count;
+    size_t len; // total length of all segments
+    bool is_null_terminated; // single segment with a null written in place after the data
+} IotConnectC2dMessage;
+
+typedef void (*IotConnectC2dCallback)(const IotConnectC2dMessage *message);
 
 typedef struct {
     char *host;    // IoTHub host to connect the client to
@@ -26,13 +45,87 @@ typedef struct {
 
 UINT iothub_client_init(IotConnectIotHubConfig *c, IotConnectAzrtosConfig* azrtos_config);
 
+// Releases the client, also after the connection was lost
 void iothub_client_disconnect(void);
 
+// Connects the existing client again after the connection was lost.
+// Returns NX_NOT_ENABLED if the client was released and needs to be initialized again.
+UINT iothub_client_reconnect(void);
+
+// Status reported with the last lost connection or failed connect. NX_SUCCESS if the disconnect was requested.
+UINT iothub_client_get_disconnect_reason(void);
+
 bool iothub_client_is_connected(void);
 
+// Number of free packets in the packet pool used by the IoTHub client
+ULONG iothub_client_available_packets(void);
+
+// URL encodes the property items as name=value&name=value into buffer. The result is null terminated.
+// Returns NX_SIZE_ERROR if the buffer is too small.
+UINT iothub_message_properties_encode(const IotConnectMessageProperty *items, size_t count,
+        char *buffer, size_t buffer_size, size_t *len);
+
 // send a null terminated string to IoTHub
 UINT iothub_send_message(const char *message);
 
+// send len bytes of (possibly binary) data to IoTHub with optional message properties
+UINT iothub_send_message_n(const void *data, size_t len, const IotConnectMessageProperties *properties);
+
+// same as iothub_send_message_n(), but with the given MQTT QoS (0 or 1) instead of the default telemetry QoS.
+// QoS 0 messages are fire-and-forget and are dropped rather than waiting for packets from the pool.
+// Once the packet is built, the publish waits for the TCP window like any other message.
+UINT iothub_send_message_qos(const void *data, size_t len, const IotConnectMessageProperties *properties, UINT qos);
+
+/*
+Zero-copy telemetry. The payload is written directly into the telemetry NX_PACKET
+and additional packets are chained from the packet pool as needed, so that the message
+does not need to be serialized into an intermediate buffer first.
+
+    IotConnectTelemetryPacket tp;
+    if (!iothub_telemetry_packet_create(&tp, NULL)) {
+        iothub_telemetry_packet_write(&tp, "{", 1);
+        ...
+        iothub_telemetry_packet_send(&tp); // the packet is released by the call
+    }
+
+Writes are sticky on error. Once a write fails, subsequent writes are ignored
+and iothub_telemetry_packet_send() will return the original error and release the packet.
+*/
+typedef struct {
+    NX_PACKET *packet_ptr;
+    UINT topic_len;
+    UCHAR packet_id[2];
+    UINT status; // first error encountered while writing
+    UINT qos;
+    UINT wait_option; // for packet allocation only
+} IotConnectTelemetryPacket;
+
+// properties can be NULL
+UINT iothub_telemetry_packet_create(IotConnectTelemetryPacket *tp, const IotConnectMessageProperties *properties);
+
+// Same as iothub_telemetry_packet_create(), but the message will be published with the given MQTT QoS (0 or 1)
+UINT iothub_telemetry_packet_create_qos(IotConnectTelemetryPacket *tp, const IotConnectMessageProperties *properties,
+        UINT qos);
+
+// Returns a pointer to at least min_len contiguous bytes of free payload space and sets *available
+// to the total number of contiguous bytes that can be written at that location.
+// Call iothub_telemetry_packet_commit() with the number of bytes actually written.
+UCHAR *iothub_telemetry_packet_reserve(IotConnectTelemetryPacket *tp, size_t min_len, size_t *available);
+
+void iothub_telemetry_packet_commit(IotConnectTelemetryPacket *tp, size_t len);
+
+UINT iothub_telemetry_packet_write(IotConnectTelemetryPacket *tp, const void *data, size_t len);
+
+// Sends the packet. The packet is released by this call, regardless of the outcome.
+UINT iothub_telemetry_packet_send(IotConnectTelemetryPacket *tp);
+
+// Releases a packet that will not be sent.
+void iothub_telemetry_packet_delete(IotConnectTelemetryPacket *tp);
+
+// Copies up to buffer_size bytes of the message, starting at offset, into the buffer.
+// Returns the number of bytes copied.
+size_t iothub_c2d_message_copy(const IotConnectC2dMessage *message, size_t offset, void *buffer, size_t buffer_size);
+
 /**
 Receive message(s) from IoTHub when a message is received, status_cb is called.
 
@@ -41,6 +134,10 @@ wait_time will be ignored in this case and set NX_WAIT_FOREVER.
 
 If calling from a single thread (loop_forever = false)
 that will be sending and receiving set wait time to the desired value as a multiple of NX_IP_PERIODIC_RATE.
+
+If IOTC_ENABLE_RECEIVE_THREAD is set, messages are received and dispatched only by a dedicated thread
+as soon as they arrive. This function then does not receive anything. It only waits for wait_ticks
+(or while connected if loop_forever is set) and returns NX_AZURE_IOT_NO_PACKET.
  *
  */
 UINT iothub_c2d_receive(bool loop_forever, ULONG wait_ticks);
@@ -9,6 +9,7 @@
 extern   "C" {
 #endif
 
+#include <stddef.h>
 #include <time.h>
 #include "tx_api.h"
 #include "nx_api.h"
@@ -19,6 +20,21 @@ UINT sntp_time_sync(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr, co
 // required function for azure RTOS
 UINT unix_time_get(ULONG *unix_time);
 
+// Milliseconds since the Unix epoch. Keeps the SNTP fraction and the remainder of the system ticks,
+// so that samples taken within the same second get distinct timestamps.
+UINT unix_time_get_ms(ULONG64 *unix_time_ms);
+
+// Size of a buffer that can hold an ISO timestamp like 2021-04-19T12:34:56.789Z
+#define UNIX_TIME_ISO_BUFFER_SIZE (25)
+
+// Formats the time as an ISO 8601 UTC timestamp with milliseconds. Returns the buffer.
+const char *unix_time_format_iso(ULONG64 unix_time_ms, char *buffer, size_t buffer_size);
+
+// Same as unix_time_format_iso() with the current time.
+// Use it instead of iotcl_iso_timestamp_now(), which has whole second resolution,
+// so that messages sent within the same second keep their order.
+const char *unix_time_iso_now(char *buffer, size_t buffer_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,30 @@
 #ifndef IOTCONNECT_HTTPS_CERT_BUFFERSIZE
 #define IOTCONNECT_HTTPS_CERT_BUFFERSIZE  4000
 #endif
+
+// With NX_DNS_CACHE_ENABLE, the DNS client keeps the resolved addresses for as long as their TTL allows,
+// so that repeated requests and download reconnects skip the DNS lookup. This is the size of the cache
+// that we give it, unless the application has set one up already.
+#ifndef IOTCONNECT_HTTPS_DNS_CACHE_SIZE
+#define IOTCONNECT_HTTPS_DNS_CACHE_SIZE 1024
+#endif
+
+// The connection is not kept for longer host names
+#define KEPT_HOST_NAME_MAX_LEN 79
+
+// A connection kept open is closed if it is not reused within this time
+#ifndef IOTCONNECT_HTTPS_KEEP_ALIVE_IDLE_S
+#define IOTCONNECT_HTTPS_KEEP_ALIVE_IDLE_S 30
+#endif
+
+#if defined(IOTC_ENABLE_HTTPS_KEEP_ALIVE) && defined(NX_WEB_HTTP_KEEPALIVE_DISABLE)
+#error "IOTC_ENABLE_HTTPS_KEEP_ALIVE requires the HTTP client keep-alive support. Do not define NX_WEB_HTTP_KEEPALIVE_DISABLE"
+#endif
+
+#if defined(IOTC_ENABLE_HTTPS_KEEP_ALIVE) && defined(IOTC_HTTP_RAM_USAGE_HACK)
+#error "IOTC_ENABLE_HTTPS_KEEP_ALIVE cannot be used with IOTC_HTTP_RAM_USAGE_HACK, as the TLS buffer is shared with MQTT"
+#endif
+
 #define HDR_CT_NAME "Content-Type"
 #define HDR_CT_VALUE "application/json" // for content type
 
@@ -63,11 +87,101 @@ static NX_SECURE_X509_DNS_NAME dns_name;
 // single request only support. Record current request for tls callback
 static IotConnectHttpRequest *current_request = NULL;
 
+// Requests come from the application, the sync thread and the command workers, while the buffers above,
+// the DNS cache setup and the kept connection are shared. The mutex lets them take turns.
+static TX_MUTEX request_mutex;
+static volatile bool is_mutex_created = false;
+
+static void request_lock(void) {
+    if (!is_mutex_created) {
+        // The first request may race with another one, so create the mutex only once with interrupts disabled
+        UINT old_posture = tx_interrupt_control(TX_INT_DISABLE);
+        if (!is_mutex_created) {
+            tx_mutex_create(&request_mutex, "IOTC HTTPS", TX_INHERIT);
+            is_mutex_created = true;
+        }
+        tx_interrupt_control(old_posture);
+    }
+    tx_mutex_get(&request_mutex, TX_WAIT_FOREVER);
+}
+
+static void request_unlock(void) {
+    tx_mutex_put(&request_mutex);
+}
+
+#ifdef NX_DNS_CACHE_ENABLE
+static ULONG dns_cache[IOTCONNECT_HTTPS_DNS_CACHE_SIZE / sizeof(ULONG)];
+static NX_DNS *dns_cache_owner = NULL;
+
+static void dns_cache_setup(NX_DNS *dns_ptr) {
+    if (dns_cache_owner || NX_NULL != dns_ptr->nx_dns_cache) {
+        return; // ours is in use, or the application has its own
+    }
+    UINT status = nx_dns_cache_initialize(dns_ptr, dns_cache, sizeof(dns_cache));
+    if (status) {
+        printf("HTTP: DNS cache setup failed: 0x%x\r\n", status);
+        return;
+    }
+    dns_cache_owner = dns_ptr;
+}
+#endif
+
+static UINT resolve_host(IotConnectHttpRequest *r, ULONG *address) {
+#ifdef NX_DNS_CACHE_ENABLE
+    dns_cache_setup(r->azrtos_config->dns_ptr);
+#endif
+    return nx_dns_host_by_name_get(
+            r->azrtos_config->dns_ptr,
+            (UCHAR*) r->host_name,
+            address,
+            5 * NX_IP_PERIODIC_RATE
+    ); // give it 5 seconds to resolve
+}
+
+#ifdef IOTC_ENABLE_HTTPS_KEEP_ALIVE
+// The TLS buffers are shared by all requests, so only one connection can be kept open
+static NX_WEB_HTTP_CLIENT kept_client;
+static bool is_client_kept = false;
+static char kept_host_name[KEPT_HOST_NAME_MAX_LEN + 1];
+static ULONG kept_ticks; // when the connection was last used
+
+// Returns the kept client if it is connected to the host and was used recently. Closes it otherwise.
+// A connection that the server has closed is not reused, as the HTTP client would not end its TLS session
+// before setting up a new one.
+static NX_WEB_HTTP_CLIENT *take_kept_client(const char *host_name) {
+    if (!is_client_kept) {
+        return NULL;
+    }
+    is_client_kept = false;
+    if (0 == strcmp(kept_host_name, host_name)
+            && tx_time_get() - kept_ticks < IOTCONNECT_HTTPS_KEEP_ALIVE_IDLE_S * TX_TIMER_TICKS_PER_SECOND
+            && NX_SUCCESS == nx_tcp_socket_state_wait(&kept_client.nx_web_http_client_socket, NX_TCP_ESTABLISHED, 0)) {
+        return &kept_client;
+    }
+    nx_web_http_client_delete(&kept_client);
+    return NULL;
+}
+#endif
+
+void iotconnect_https_close(void) {
+#ifdef IOTC_ENABLE_HTTPS_KEEP_ALIVE
+    request_lock();
+    if (is_client_kept) {
+        is_client_kept = false;
+        nx_web_http_client_delete(&kept_client);
+    }
+    request_unlock();
+#endif
+}
+
 static UINT tls_setup_callback(NX_WEB_HTTP_CLIENT *client_ptr, NX_SECURE_TLS_SESSION *tls_session);
 
-UINT iotconnect_https_request(IotConnectHttpRequest *r) {
+// Sets *is_stale_connection if the request failed on a kept connection before any of the response arrived.
+// The server may have closed the connection after it was checked, so the request can be sent again.
+static UINT https_request_locked(IotConnectHttpRequest *r, bool *is_stale_connection) {
     UINT status;
-    NX_WEB_HTTP_CLIENT http_client;
+    NX_WEB_HTTP_CLIENT local_client;
+    NX_WEB_HTTP_CLIENT *http_client = NULL;
     NXD_ADDRESS server_ip_address;
 
     if (!r ||  !r->azrtos_config || !r->host_name || !r->tls_cert || 0 == r->tls_cert_len) {
@@ -77,26 +191,37 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
 
     r->response = response_buffer;
     r->response[0] = 0; // null terminate
+    *is_stale_connection = false;
+
+    bool is_kept_client_reused = false;
+#ifdef IOTC_ENABLE_HTTPS_KEEP_ALIVE
+    http_client = take_kept_client(r->host_name);
+    is_kept_client_reused = (NULL != http_client);
+    // Custom handlers may not read the whole response, so their connections are not kept
+    if (!http_client && !r->custom_handler_cb && strlen(r->host_name) <= KEPT_HOST_NAME_MAX_LEN) {
+        http_client = &kept_client;
+    }
+#endif
+    if (!http_client) {
+        http_client = &local_client;
+    }
 
-    status = nx_web_http_client_create(
-            &http_client, "IoTConnect Client",
-            r->azrtos_config->ip_ptr,
-            r->azrtos_config->pool_ptr,
-            NX_WEB_HTTP_TCP_WINDOW_SIZE);
-    if (status) {
-        printf("HTTP: Client create failed: 0x%x\r\n", status);
-        return status;
+    if (!is_kept_client_reused) {
+        status = nx_web_http_client_create(
+                http_client, "IoTConnect Client",
+                r->azrtos_config->ip_ptr,
+                r->azrtos_config->pool_ptr,
+                NX_WEB_HTTP_TCP_WINDOW_SIZE);
+        if (status) {
+            printf("HTTP: Client create failed: 0x%x\r\n", status);
+            return status;
+        }
     }
 
-    status = nx_dns_host_by_name_get(
-            r->azrtos_config->dns_ptr,
-            (UCHAR*) r->host_name,
-            &server_ip_address.nxd_ip_address.v4,
-            5 * NX_IP_PERIODIC_RATE
-    ); // give it 5 seconds to resolve
+    status = resolve_host(r, &server_ip_address.nxd_ip_address.v4);
     if (status) {
         printf("HTTP: Host DNS resolution failed 0x%x\r\n", status);
-        nx_web_http_client_delete(&http_client);
+        nx_web_http_client_delete(http_client);
         return status;
     }
 
@@ -105,8 +230,9 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
 
     current_request = r;
     server_ip_address.nxd_ip_version = NX_IP_VERSION_V4;
+    // returns right away for a kept connection
     status = nx_web_http_client_secure_connect(
-            &http_client, //
+            http_client, //
             &server_ip_address,//
             NX_WEB_HTTPS_SERVER_PORT,//
             tls_setup_callback,//
@@ -115,15 +241,15 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
 
     if (status) {
         printf("HTTP: Error in HTTP Connect: 0x%x\r\n", status);
-        nx_web_http_client_delete(&http_client);
+        nx_web_http_client_delete(http_client);
         return status;
     }
 
 
     // PROVIDED HANDLER CALLBACK
     if (r->custom_handler_cb) {
-        status = r->custom_handler_cb(r, &http_client);
-        nx_web_http_client_delete(&http_client);
+        status = r->custom_handler_cb(r, http_client);
+        nx_web_http_client_delete(http_client);
         return status;
     }
 
@@ -132,8 +258,11 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
         return NX_INVALID_PARAMETERS;
     }
 
+    // until the first response bytes arrive
+    *is_stale_connection = is_kept_client_reused;
+
     if (r->payload) {
-        status = nx_web_http_client_request_initialize(&http_client,
+        status = nx_web_http_client_request_initialize(http_client,
                 NX_WEB_HTTP_METHOD_POST,
                 r->resource, r->host_name,
                 strlen(r->payload),          //  POST input size needed here
@@ -145,22 +274,22 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
 
         if (status != NX_SUCCESS) {
             printf("HTTP: Error in HTTP PUT request initialization: 0x%x\r\n", status);
-            nx_web_http_client_delete(&http_client);
+            nx_web_http_client_delete(http_client);
             return status;
         }
 
-        status = nx_web_http_client_request_header_add(&http_client,
+        status = nx_web_http_client_request_header_add(http_client,
                 HDR_CT_NAME, strlen(HDR_CT_NAME),
                 HDR_CT_VALUE, strlen(HDR_CT_VALUE),
                 NX_WAIT_FOREVER);
 
         if (status != NX_SUCCESS) {
             printf("HTTP: Error in HTTP request headers setup: 0x%x\r\n", status);
-            nx_web_http_client_delete(&http_client);
+            nx_web_http_client_delete(http_client);
             return status;
         }
     } else {
-        status = nx_web_http_client_request_initialize(&http_client,
+        status = nx_web_http_client_request_initialize(http_client,
                 NX_WEB_HTTP_METHOD_GET, /* GET, PUT, DELETE, POST, HEAD */
                 r->resource, r->host_name, 0, /* PUT and POST need an input size. */
                 NX_FALSE, /* If true, input_size is ignored. */
@@ -169,26 +298,26 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
                 NX_WAIT_FOREVER);
         if (status != NX_SUCCESS) {
             printf("HTTP: Error in HTTP GET request initialization: 0x%x\r\n", status);
-            nx_web_http_client_delete(&http_client);
+            nx_web_http_client_delete(http_client);
             return status;
         }
     }
 
     // common for both GET and POST
-    status = nx_web_http_client_request_send(&http_client, NX_WAIT_FOREVER);
+    status = nx_web_http_client_request_send(http_client, NX_WAIT_FOREVER);
     if (status) {
         printf("HTTP: Error in HTTP request send: 0x%x\r\n", status);
-        nx_web_http_client_delete(&http_client);
+        nx_web_http_client_delete(http_client);
         return status;
     }
 
     if (r->payload) {
         NX_PACKET *packet_ptr;
         /* Create a new data packet request on the HTTP(S) client instance. */
-        nx_web_http_client_request_packet_allocate(&http_client, &packet_ptr, NX_WAIT_FOREVER);
+        nx_web_http_client_request_packet_allocate(http_client, &packet_ptr, NX_WAIT_FOREVER);
         if (status != NX_SUCCESS) {
             printf("HTTP: Error while allocating packet: 0x%x\r\n", status);
-            nx_web_http_client_delete(&http_client);
+            nx_web_http_client_delete(http_client);
             return status;
         }
 
@@ -197,15 +326,15 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
                                        NX_WAIT_FOREVER);
         if (status) {
             printf("HTTP: Error while appending packet data: 0x%x\r\n", status);
-            nx_web_http_client_delete(&http_client);
+            nx_web_http_client_delete(http_client);
             return(status);
         }
 
          /* Send data packet request to server. */
-        status = nx_web_http_client_request_packet_send(&http_client, packet_ptr, 0, NX_WAIT_FOREVER);
+        status = nx_web_http_client_request_packet_send(http_client, packet_ptr, 0, NX_WAIT_FOREVER);
         if (status) {
             printf("HTTP: Error sending packet: 0x%x\r\n", status);
-            nx_web_http_client_delete(&http_client);
+            nx_web_http_client_delete(http_client);
             return(status);
         }
 
@@ -216,7 +345,7 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
     UINT get_status = NX_SUCCESS;
     size_t data_length = 0;
     while (get_status != NX_WEB_HTTP_GET_DONE) {
-    	get_status = nx_web_http_client_response_body_get(&http_client, &receive_packet, NX_WAIT_FOREVER);
+    	get_status = nx_web_http_client_response_body_get(http_client, &receive_packet, NX_WAIT_FOREVER);
 
         /* Check for error.  */
         if (get_status != NX_SUCCESS && get_status != NX_WEB_HTTP_GET_DONE) {
@@ -224,6 +353,7 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
             status = get_status;
             break;
         }
+        *is_stale_connection = false;
 
 		UINT packet_len = receive_packet->nx_packet_length;
 		if (packet_len == 0) {
@@ -262,7 +392,20 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
     if (receive_packet) {
     	nx_packet_release(receive_packet);
     }
-    status = nx_web_http_client_delete(&http_client);
+    if (*is_stale_connection) {
+        nx_web_http_client_delete(http_client);
+        return status;
+    }
+#ifdef IOTC_ENABLE_HTTPS_KEEP_ALIVE
+    // keep the connection if the whole response was read and the server did not ask to close it
+    if (http_client == &kept_client && NX_WEB_HTTP_GET_DONE == get_status && kept_client.nx_web_http_client_keep_alive) {
+        strcpy(kept_host_name, r->host_name);
+        kept_ticks = tx_time_get();
+        is_client_kept = true;
+        return NX_SUCCESS;
+    }
+#endif
+    status = nx_web_http_client_delete(http_client);
     if (status != NX_SUCCESS) {
         printf("Warning to delete web client: 0x%x\r\n", status);
     }
@@ -270,6 +413,19 @@ UINT iotconnect_https_request(IotConnectHttpRequest *r) {
     return NX_SUCCESS;
 }
 
+UINT iotconnect_https_request(IotConnectHttpRequest *r) {
+    bool is_stale_connection;
+    request_lock();
+    UINT status = https_request_locked(r, &is_stale_connection);
+    if (status && is_stale_connection) {
+        // the kept connection was deleted, so this one goes over a new connection
+        printf("HTTP: The kept connection was closed by the server. Retrying on a new connection.\r\n");
+        status = https_request_locked(r, &is_stale_connection);
+    }
+    request_unlock();
+    return status;
+}
+
 static ULONG iotc_https_certificate_verify(NX_SECURE_TLS_SESSION *session, NX_SECURE_X509_CERT* certificate)
 {
     (void) session; // unused
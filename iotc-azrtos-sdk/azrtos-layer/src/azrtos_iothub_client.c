@@ -16,6 +16,7 @@
 
 #include "tx_api.h"
 #include "nx_api.h"
+#include "nx_azure_iot.h"
 #include "nx_azure_iot_hub_client.h"
 #include "nx_azure_iot_ciphersuites.h"
 #include "azrtos_time.h"
@@ -23,7 +24,25 @@
 #include "iotconnect.h"
 #include "azrtos_iothub_client.h"
 #include "iotc_auth_driver.h"
+#ifdef IOTC_ENABLE_COMPRESSION
+#include "iotconnect_compress.h"
+#endif
+
+
+// Stack buffer used to encode message properties that were not preformatted
+#ifndef IOTC_MESSAGE_PROPERTIES_BUFFER_SIZE
+#define IOTC_MESSAGE_PROPERTIES_BUFFER_SIZE (128)
+#endif
 
+#ifdef IOTC_ENABLE_RECEIVE_THREAD
+#ifndef IOTC_RECEIVE_THREAD_STACK_SIZE
+#define IOTC_RECEIVE_THREAD_STACK_SIZE (4096)
+#endif
+
+#ifndef IOTC_RECEIVE_THREAD_PRIORITY
+#define IOTC_RECEIVE_THREAD_PRIORITY (4)
+#endif
+#endif // IOTC_ENABLE_RECEIVE_THREAD
 
 /* Define the Azure RTOS IOT thread stack and priority.  */
 #ifndef NX_AZURE_IOT_STACK_SIZE
@@ -57,6 +76,17 @@ static IotConnectIotHubConfig config;
 
 static bool is_connected = false;
 static bool is_disconnect_requested = false;
+static bool is_initialized = false; // the Azure IoT instance and the hub client are created
+static UINT disconnect_reason = NX_SUCCESS;
+
+#ifdef IOTC_ENABLE_RECEIVE_THREAD
+static ULONG receive_thread_stack[IOTC_RECEIVE_THREAD_STACK_SIZE / sizeof(ULONG)];
+static TX_THREAD receive_thread;
+static TX_SEMAPHORE c2d_available_sem;
+static bool is_receive_thread_created = false;
+
+static UINT c2d_receive_one(ULONG wait_ticks);
+#endif
 
 #ifdef IOTC_ENABLE_ADU_SUPPORT
 #define SAMPLE_PNP_MODEL_ID                                             "dtmi:azure:iot:deviceUpdateModel;1"
@@ -65,10 +95,13 @@ static bool is_disconnect_requested = false;
 static VOID connection_status_callback(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, UINT status) {
     NX_PARAMETER_NOT_USED(hub_client_ptr);
     if (status) {
+        const bool was_connected = is_connected; // failed connect attempts are reported by the connect call
         is_connected = false;
         if (is_disconnect_requested) {
             is_disconnect_requested = false;
+            disconnect_reason = NX_SUCCESS;
         } else {
+            disconnect_reason = status;
             //nx_azure_iot_hub_client_deinitialize(&iothub_client);
             //nx_azure_iot_delete(&nx_azure_iot);
             printf("Received a disconnect!\r\n");
@@ -77,7 +110,7 @@ static VOID connection_status_callback(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr,
         if (status != NX_AZURE_IOT_DISCONNECTED) {
             printf("Disconnected from IoTHub!: error code = 0x%08x\r\n", status);
         }
-        if (config.status_cb) {
+        if (was_connected && config.status_cb) {
             config.status_cb(MQTT_DISCONNECTED);
         }
     } else {
@@ -211,10 +244,60 @@ static void log_callback(az_log_classification classification, UCHAR *msg, UINT
     }
 }
 
+#ifdef IOTC_ENABLE_RECEIVE_THREAD
+// Called from the Azure IoT thread when a C2D message arrives. Only wakes up the receive thread,
+// so that the Azure IoT thread is not held up by the message processing.
+static VOID on_c2d_available(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, VOID *context) {
+    NX_PARAMETER_NOT_USED(hub_client_ptr);
+    NX_PARAMETER_NOT_USED(context);
+    tx_semaphore_ceiling_put(&c2d_available_sem, 1);
+}
+
+static void receive_thread_entry(ULONG parameter) {
+    NX_PARAMETER_NOT_USED(parameter);
+    while (true) {
+        tx_semaphore_get(&c2d_available_sem, TX_WAIT_FOREVER);
+        // one notification can stand for several messages
+        while (is_connected && NX_SUCCESS == c2d_receive_one(NX_NO_WAIT)) {
+        }
+    }
+}
+
+static UINT start_receive_thread(void) {
+    UINT status;
+    if (!is_receive_thread_created) {
+        if ((status = tx_semaphore_create(&c2d_available_sem, "IOTC C2D", 0))) {
+            printf("Failed to create the C2D semaphore!: error code = 0x%08x\r\n", status);
+            return status;
+        }
+        if ((status = tx_thread_create(&receive_thread, "IOTC Receive",
+                receive_thread_entry, 0,
+                receive_thread_stack, sizeof(receive_thread_stack),
+                IOTC_RECEIVE_THREAD_PRIORITY, IOTC_RECEIVE_THREAD_PRIORITY,
+                TX_NO_TIME_SLICE, TX_AUTO_START))) {
+            printf("Failed to create the receive thread!: error code = 0x%08x\r\n", status);
+            tx_semaphore_delete(&c2d_available_sem);
+            return status;
+        }
+        is_receive_thread_created = true;
+    }
+    if ((status = nx_azure_iot_hub_client_receive_callback_set(&iothub_client,
+            NX_AZURE_IOT_HUB_CLOUD_TO_DEVICE_MESSAGE, on_c2d_available, NX_NULL))) {
+        printf("Failed on nx_azure_iot_hub_client_receive_callback_set!: error code = 0x%08x\r\n", status);
+        return status;
+    }
+    // pick up anything that arrived before the callback was set
+    tx_semaphore_ceiling_put(&c2d_available_sem, 1);
+    return NX_SUCCESS;
+}
+#endif // IOTC_ENABLE_RECEIVE_THREAD
+
 UINT iothub_client_init(IotConnectIotHubConfig *c, IotConnectAzrtosConfig *azrtos_config) {
     UINT status = 0;
 
     is_connected = false;
+    is_disconnect_requested = false;
+    disconnect_reason = NX_SUCCESS;
 
     memset(&config, 0, sizeof(config));
     memcpy(&config, c, sizeof(config));
@@ -275,8 +358,9 @@ UINT iothub_client_init(IotConnectIotHubConfig *c, IotConnectAzrtosConfig *azrto
 #endif
 
     printf("Connecting...\r\n");
-    if (nx_azure_iot_hub_client_connect(&iothub_client, NX_TRUE, NX_WAIT_FOREVER)) {
-        printf("Failed on nx_azure_iot_hub_client_connect!\r\n");
+    if ((status = nx_azure_iot_hub_client_connect(&iothub_client, NX_TRUE, NX_WAIT_FOREVER))) {
+        printf("Failed on nx_azure_iot_hub_client_connect!: error code = 0x%08x\r\n", status);
+        disconnect_reason = status;
         nx_azure_iot_hub_client_deinitialize(&iothub_client);
         nx_azure_iot_delete(&nx_azure_iot);
         return status;
@@ -284,21 +368,63 @@ UINT iothub_client_init(IotConnectIotHubConfig *c, IotConnectAzrtosConfig *azrto
 
     /* Create Telemetry sample thread. */
     is_connected = true;
+    is_initialized = true;
+
+#ifdef IOTC_ENABLE_RECEIVE_THREAD
+    if ((status = start_receive_thread())) {
+        iothub_client_disconnect();
+        return status;
+    }
+#endif
     return NX_AZURE_IOT_SUCCESS;
 }
 
-void iothub_client_disconnect(void) {
+UINT iothub_client_reconnect(void) {
+    UINT status;
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
     if (is_connected) {
+        return NX_SUCCESS;
+    }
+    printf("Reconnecting...\r\n");
+    if ((status = nx_azure_iot_hub_client_connect(&iothub_client, NX_TRUE, NX_WAIT_FOREVER))) {
+        printf("Failed on nx_azure_iot_hub_client_connect!: error code = 0x%08x\r\n", status);
+        disconnect_reason = status;
+        return status;
+    }
+    is_connected = true;
+    return NX_SUCCESS;
+}
+
+void iothub_client_disconnect(void) {
+    if (!is_initialized) {
+        return;
+    }
+    is_initialized = false;
+    const bool was_connected = is_connected;
+    if (was_connected) {
         is_connected = false;
         is_disconnect_requested = true; // don't deinitialize in the callback
+        disconnect_reason = NX_SUCCESS;
         nx_azure_iot_hub_client_disconnect(&iothub_client);
-        nx_azure_iot_hub_client_deinitialize(&iothub_client);
-        nx_azure_iot_delete(&nx_azure_iot);
-        if (config.status_cb) {
-            printf("Disconnected from IoTHub.");
-            config.status_cb(MQTT_DISCONNECTED);
-        }
     }
+    // the client also needs to be released after the connection was lost
+    nx_azure_iot_hub_client_deinitialize(&iothub_client);
+    nx_azure_iot_delete(&nx_azure_iot);
+    if (was_connected && config.status_cb) {
+        printf("Disconnected from IoTHub.");
+        config.status_cb(MQTT_DISCONNECTED);
+    }
+}
+
+UINT iothub_client_get_disconnect_reason(void) {
+    return disconnect_reason;
+}
+
+ULONG iothub_client_available_packets(void) {
+    NX_PACKET_POOL *pool_ptr = nx_azure_iot.nx_azure_iot_pool_ptr;
+    return pool_ptr ? pool_ptr->nx_packet_pool_available : 0;
 }
 
 bool iothub_client_is_connected(void) {
@@ -306,18 +432,185 @@ bool iothub_client_is_connected(void) {
 }
 
 
+// unreserved URL characters, plus '$' which is used by the IoTHub system property names
+static bool is_url_safe(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')
+            || '-' == ch || '_' == ch || '.' == ch || '~' == ch || '$' == ch;
+}
+
+static bool url_encode_append(const char *str, char *buffer, size_t buffer_size, size_t *len) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (const char *p = str; *p; p++) {
+        const bool is_safe = is_url_safe(*p);
+        const size_t needed = is_safe ? 1 : 3;
+        if (*len + needed >= buffer_size) {
+            return false;
+        }
+        if (is_safe) {
+            buffer[(*len)++] = *p;
+        } else {
+            const unsigned char ch = (unsigned char) *p;
+            buffer[(*len)++] = '%';
+            buffer[(*len)++] = hex[ch >> 4];
+            buffer[(*len)++] = hex[ch & 0xf];
+        }
+    }
+    return true;
+}
+
+static bool append_char(char ch, char *buffer, size_t buffer_size, size_t *len) {
+    if (*len + 1 >= buffer_size) {
+        return false;
+    }
+    buffer[(*len)++] = ch;
+    return true;
+}
+
+UINT iothub_message_properties_encode(const IotConnectMessageProperty *items, size_t count,
+        char *buffer, size_t buffer_size, size_t *len) {
+    *len = 0;
+    if (0 == buffer_size) {
+        return NX_SIZE_ERROR;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && !append_char('&', buffer, buffer_size, len)) {
+            return NX_SIZE_ERROR;
+        }
+        if (!url_encode_append(items[i].name, buffer, buffer_size, len)
+                || !append_char('=', buffer, buffer_size, len)
+                || !url_encode_append(items[i].value, buffer, buffer_size, len)) {
+            return NX_SIZE_ERROR;
+        }
+    }
+    buffer[*len] = 0;
+    return NX_SUCCESS;
+}
+
+// Properties go into the topic, so they need to be added before the packet ID and the payload.
+// This does the same as nx_azure_iot_hub_client_telemetry_property_add(), but with all properties at once.
+static UINT add_message_properties(NX_PACKET *packet_ptr, const IotConnectMessageProperties *properties) {
+    UINT status;
+    char buffer[IOTC_MESSAGE_PROPERTIES_BUFFER_SIZE];
+    const char *formatted;
+    size_t formatted_len;
+
+    if (!properties) {
+        return NX_SUCCESS;
+    }
+    if (properties->formatted) {
+        formatted = properties->formatted;
+        formatted_len = properties->formatted_len;
+    } else {
+        if ((status = iothub_message_properties_encode(properties->items, properties->count,
+                buffer, sizeof(buffer), &formatted_len))) {
+            printf("Telemetry properties exceed IOTC_MESSAGE_PROPERTIES_BUFFER_SIZE\r\n");
+            return status;
+        }
+        formatted = buffer;
+    }
+    if (0 == formatted_len) {
+        return NX_SUCCESS;
+    }
+    if (*(packet_ptr->nx_packet_append_ptr - 1) != '/') {
+        if ((status = nx_packet_data_append(packet_ptr, "&", 1, packet_ptr->nx_packet_pool_owner, NX_WAIT_FOREVER))) {
+            printf("Telemetry property add failed!: error code = 0x%08x\r\n", status);
+            return status;
+        }
+    }
+    if ((status = nx_packet_data_append(packet_ptr, (VOID *) formatted, (ULONG) formatted_len,
+            packet_ptr->nx_packet_pool_owner, NX_WAIT_FOREVER))) {
+        printf("Telemetry property add failed!: error code = 0x%08x\r\n", status);
+        return status;
+    }
+    return NX_SUCCESS;
+}
+
+#ifdef IOTC_ENABLE_COMPRESSION
+// Sends the message gzip compressed, with the content encoding added to the given properties.
+// Returns NX_SIZE_ERROR without sending if the message would not get smaller.
+static UINT send_compressed(const void *data, size_t len, const IotConnectMessageProperties *properties) {
+    UINT status;
+    char buffer[IOTC_MESSAGE_PROPERTIES_BUFFER_SIZE];
+    size_t buffer_len = 0;
+    IotConnectMessageProperties compressed_properties = { 0 };
+    IotConnectTelemetryPacket tp;
+
+    if (properties && properties->formatted) {
+        if (properties->formatted_len >= sizeof(buffer)) {
+            return NX_SIZE_ERROR;
+        }
+        memcpy(buffer, properties->formatted, properties->formatted_len);
+        buffer_len = properties->formatted_len;
+    } else if (properties) {
+        if (iothub_message_properties_encode(properties->items, properties->count, buffer, sizeof(buffer),
+                &buffer_len)) {
+            return NX_SIZE_ERROR;
+        }
+    }
+    if ((buffer_len > 0 && !append_char('&', buffer, sizeof(buffer), &buffer_len))
+            || !url_encode_append(IOTC_PROPERTY_CONTENT_ENCODING, buffer, sizeof(buffer), &buffer_len)
+            || !append_char('=', buffer, sizeof(buffer), &buffer_len)
+            || !url_encode_append(IOTC_COMPRESS_CONTENT_ENCODING, buffer, sizeof(buffer), &buffer_len)) {
+        return NX_SIZE_ERROR;
+    }
+    compressed_properties.formatted = buffer;
+    compressed_properties.formatted_len = buffer_len;
+
+    if ((status = iothub_telemetry_packet_create(&tp, &compressed_properties))) {
+        return status;
+    }
+    if ((status = iotc_compress_gzip_packet(data, len, &tp, NULL))) {
+        iothub_telemetry_packet_delete(&tp);
+        return status;
+    }
+    return iothub_telemetry_packet_send(&tp);
+}
+#endif // IOTC_ENABLE_COMPRESSION
+
 UINT iothub_send_message(const char *message) {
+    return iothub_send_message_n(message, strlen(message), NULL);
+}
+
+UINT iothub_send_message_qos(const void *data, size_t len, const IotConnectMessageProperties *properties, UINT qos) {
+    UINT status;
+    IotConnectTelemetryPacket tp;
+    if (NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS == qos) {
+        return iothub_send_message_n(data, len, properties);
+    }
+    if ((status = iothub_telemetry_packet_create_qos(&tp, properties, qos))) {
+        return status;
+    }
+    iothub_telemetry_packet_write(&tp, data, len);
+    return iothub_telemetry_packet_send(&tp); // reports and releases on write errors as well
+}
+
+UINT iothub_send_message_n(const void *data, size_t len, const IotConnectMessageProperties *properties) {
     UINT status = 0;
     NX_PACKET *packet_ptr;
 
+#ifdef IOTC_ENABLE_COMPRESSION
+    if (iotc_compress_should_compress(len, properties)) {
+        status = send_compressed(data, len, properties);
+        if (NX_SIZE_ERROR != status) {
+            return status;
+        }
+        // the message does not compress, so send it as it is
+    }
+#endif
+
     /* Create a telemetry message packet. */
     if ((status = nx_azure_iot_hub_client_telemetry_message_create(&iothub_client, &packet_ptr, NX_WAIT_FOREVER))) {
         printf("Telemetry message create failed!: error code = 0x%08x\r\n", status);
         return status;
     }
 
-    if (nx_azure_iot_hub_client_telemetry_send(&iothub_client, packet_ptr, (UCHAR*) message, strlen(message),
-    NX_WAIT_FOREVER)) {
+    if ((status = add_message_properties(packet_ptr, properties))) {
+        nx_azure_iot_hub_client_telemetry_message_delete(packet_ptr);
+        return status;
+    }
+
+    if ((status = nx_azure_iot_hub_client_telemetry_send(&iothub_client, packet_ptr, (const UCHAR*) data, (UINT) len,
+    NX_WAIT_FOREVER))) {
         printf("Telemetry message send failed!: error code = 0x%08x\r\n", status);
         nx_azure_iot_hub_client_telemetry_message_delete(packet_ptr);
         return status;
@@ -326,37 +619,259 @@ UINT iothub_send_message(const char *message) {
     return NX_SUCCESS;
 }
 
+UINT iothub_telemetry_packet_create(IotConnectTelemetryPacket *tp, const IotConnectMessageProperties *properties) {
+    return iothub_telemetry_packet_create_qos(tp, properties, NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS);
+}
+
+UINT iothub_telemetry_packet_create_qos(IotConnectTelemetryPacket *tp, const IotConnectMessageProperties *properties,
+        UINT qos) {
+    UINT status;
+    NXD_MQTT_CLIENT *mqtt_client = &(iothub_client.nx_azure_iot_hub_client_resource.resource_mqtt);
+
+    memset(tp, 0, sizeof(IotConnectTelemetryPacket));
+    if (qos > 1) {
+        return NX_INVALID_PARAMETERS; // IoTHub does not support QoS 2
+    }
+    tp->qos = qos;
+    // Fire-and-forget. Rather drop the message than wait for the packet pool.
+    // The publish itself always waits. See iothub_telemetry_packet_send().
+    tp->wait_option = (0 == qos) ? NX_NO_WAIT : NX_WAIT_FOREVER;
+    if ((status = nx_azure_iot_hub_client_telemetry_message_create(&iothub_client, &tp->packet_ptr, tp->wait_option))) {
+        printf("Telemetry message create failed!: error code = 0x%08x\r\n", status);
+        tp->packet_ptr = NULL;
+        return status;
+    }
+
+    // properties are a part of the topic, so they need to be added before anything else
+    if ((status = add_message_properties(tp->packet_ptr, properties))) {
+        iothub_telemetry_packet_delete(tp);
+        return status;
+    }
+
+    // We replicate what nx_azure_iot_hub_client_telemetry_send() does, except that
+    // the payload will be written directly into the packet after the packet ID.
+    tp->topic_len = tp->packet_ptr->nx_packet_length;
+    if (0 == qos) {
+        return NX_SUCCESS; // QoS 0 publish has no packet ID
+    }
+    if ((status = nx_azure_iot_mqtt_packet_id_get(mqtt_client, tp->packet_id, NX_WAIT_FOREVER))) {
+        printf("Telemetry packet ID get failed!: error code = 0x%08x\r\n", status);
+        iothub_telemetry_packet_delete(tp);
+        return status;
+    }
+    if ((status = nx_packet_data_append(tp->packet_ptr, tp->packet_id, sizeof(tp->packet_id),
+            tp->packet_ptr->nx_packet_pool_owner, NX_WAIT_FOREVER))) {
+        printf("Telemetry packet ID append failed!: error code = 0x%08x\r\n", status);
+        iothub_telemetry_packet_delete(tp);
+        return status;
+    }
+    return NX_SUCCESS;
+}
+
+// Without packet chaining the whole message is always in the head packet
+static NX_PACKET *telemetry_packet_last(IotConnectTelemetryPacket *tp) {
+#ifndef NX_DISABLE_PACKET_CHAIN
+    if (tp->packet_ptr->nx_packet_last) {
+        return tp->packet_ptr->nx_packet_last;
+    }
+#endif
+    return tp->packet_ptr;
+}
+
+UCHAR *iothub_telemetry_packet_reserve(IotConnectTelemetryPacket *tp, size_t min_len, size_t *available) {
+    if (!tp->packet_ptr || tp->status) {
+        return NULL;
+    }
+    NX_PACKET *last = telemetry_packet_last(tp);
+    size_t free_space = (size_t) (last->nx_packet_data_end - last->nx_packet_append_ptr);
+    if (free_space > 0 && free_space >= min_len) {
+        *available = free_space;
+        return last->nx_packet_append_ptr;
+    }
+
+#ifndef NX_DISABLE_PACKET_CHAIN
+    NX_PACKET *next;
+    UINT status = nx_packet_allocate(tp->packet_ptr->nx_packet_pool_owner, &next, NX_RECEIVE_PACKET, tp->wait_option);
+    if (status) {
+        printf("Telemetry packet allocation failed!: error code = 0x%08x\r\n", status);
+        tp->status = status;
+        return NULL;
+    }
+    free_space = (size_t) (next->nx_packet_data_end - next->nx_packet_append_ptr);
+    if (free_space < min_len) {
+        nx_packet_release(next);
+        tp->status = NX_SIZE_ERROR;
+        return NULL;
+    }
+    last->nx_packet_next = next;
+    tp->packet_ptr->nx_packet_last = next;
+    *available = free_space;
+    return next->nx_packet_append_ptr;
+#else
+    tp->status = NX_SIZE_ERROR;
+    return NULL;
+#endif
+}
+
+void iothub_telemetry_packet_commit(IotConnectTelemetryPacket *tp, size_t len) {
+    NX_PACKET *last = telemetry_packet_last(tp);
+    last->nx_packet_append_ptr += len;
+    tp->packet_ptr->nx_packet_length += len; // only the head packet tracks the total length
+}
+
+UINT iothub_telemetry_packet_write(IotConnectTelemetryPacket *tp, const void *data, size_t len) {
+    const UCHAR *src = (const UCHAR *) data;
+    while (len > 0) {
+        size_t available;
+        UCHAR *dst = iothub_telemetry_packet_reserve(tp, 1, &available);
+        if (!dst) {
+            return tp->status ? tp->status : NX_INVALID_PARAMETERS;
+        }
+        size_t chunk = len < available ? len : available;
+        memcpy(dst, src, chunk);
+        iothub_telemetry_packet_commit(tp, chunk);
+        src += chunk;
+        len -= chunk;
+    }
+    return tp->status;
+}
+
+UINT iothub_telemetry_packet_send(IotConnectTelemetryPacket *tp) {
+    UINT status;
+    if (!tp->packet_ptr) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (tp->status) {
+        status = tp->status;
+        iothub_telemetry_packet_delete(tp);
+        return status;
+    }
+    // Never use NX_NO_WAIT here, even for QoS 0. By the time the TCP send fails on a full window, NetX Secure
+    // has already encrypted the record and advanced the TLS sequence number, so the next record would fail
+    // the server's MAC check and the connection would be torn down.
+    status = nx_azure_iot_publish_packet_send(&(iothub_client.nx_azure_iot_hub_client_resource.resource_mqtt),
+            tp->packet_ptr, tp->topic_len, tp->packet_id, tp->qos, NX_WAIT_FOREVER);
+    if (status) {
+        printf("Telemetry message send failed!: error code = 0x%08x\r\n", status);
+        iothub_telemetry_packet_delete(tp);
+        return status;
+    }
+    tp->packet_ptr = NULL; // now owned by the network stack
+    return NX_SUCCESS;
+}
+
+void iothub_telemetry_packet_delete(IotConnectTelemetryPacket *tp) {
+    if (tp->packet_ptr) {
+        nx_azure_iot_hub_client_telemetry_message_delete(tp->packet_ptr);
+        tp->packet_ptr = NULL;
+    }
+}
+
+// Fills the scatter-gather view of the packet chain. Returns false if the message spans too many packets.
+static bool c2d_message_init(NX_PACKET *packet_ptr, IotConnectC2dMessage *message) {
+    message->segment_count = 0;
+    message->len = 0;
+    message->is_null_terminated = false;
+#ifndef NX_DISABLE_PACKET_CHAIN
+    for (NX_PACKET *p = packet_ptr; p && message->len < packet_ptr->nx_packet_length; p = p->nx_packet_next) {
+#else
+    for (NX_PACKET *p = packet_ptr; p && message->len < packet_ptr->nx_packet_length; p = NULL) {
+#endif
+        size_t len = (size_t) (p->nx_packet_append_ptr - p->nx_packet_prepend_ptr);
+        if (len > packet_ptr->nx_packet_length - message->len) {
+            len = packet_ptr->nx_packet_length - message->len;
+        }
+        if (0 == len) {
+            continue;
+        }
+        if (message->segment_count >= IOTC_C2D_MAX_SEGMENTS) {
+            printf("C2D message of %lu bytes exceeds IOTC_C2D_MAX_SEGMENTS packets\r\n", packet_ptr->nx_packet_length);
+            return false;
+        }
+        message->segments[message->segment_count].data = p->nx_packet_prepend_ptr;
+        message->segments[message->segment_count].len = len;
+        message->segment_count++;
+        message->len += len;
+    }
+    // Most messages fit into a single packet. Terminate them in place so that they can be parsed without a copy.
+    if (1 == message->segment_count
+#ifndef NX_DISABLE_PACKET_CHAIN
+            && NULL == packet_ptr->nx_packet_next
+#endif
+            && packet_ptr->nx_packet_append_ptr < packet_ptr->nx_packet_data_end) {
+        *packet_ptr->nx_packet_append_ptr = 0;
+        message->is_null_terminated = true;
+    }
+    return true;
+}
+
+size_t iothub_c2d_message_copy(const IotConnectC2dMessage *message, size_t offset, void *buffer, size_t buffer_size) {
+    UCHAR *dst = (UCHAR *) buffer;
+    size_t copied = 0;
+    for (UINT i = 0; i < message->segment_count && copied < buffer_size; i++) {
+        const IotConnectC2dSegment *segment = &message->segments[i];
+        if (offset >= segment->len) {
+            offset -= segment->len;
+            continue;
+        }
+        size_t chunk = segment->len - offset;
+        if (chunk > buffer_size - copied) {
+            chunk = buffer_size - copied;
+        }
+        memcpy(&dst[copied], &segment->data[offset], chunk);
+        copied += chunk;
+        offset = 0;
+    }
+    return copied;
+}
+
+// Receives and dispatches a single message. Returns NX_AZURE_IOT_NO_PACKET if there was none.
+static UINT c2d_receive_one(ULONG wait_ticks) {
+    NX_PACKET *packet_ptr = NULL;
+    UINT status = nx_azure_iot_hub_client_cloud_message_receive(&iothub_client, &packet_ptr, wait_ticks);
+
+    if ((NX_AZURE_IOT_NO_PACKET != status && NX_SUCCESS != status)) {
+        printf("C2D receive failed!: error code = 0x%08x\r\n", status);
+        return status;
+    }
+
+    if (NX_SUCCESS == status) {
+        IotConnectC2dMessage message;
+        if (c2d_message_init(packet_ptr, &message)) {
+            config.c2d_msg_cb(&message);
+        }
+#if 0
+        printf("Received message:");
+        printf_packet(packet_ptr);
+        printf("\r\n");
+#endif
+    }
+    if (packet_ptr) {
+        nx_packet_release(packet_ptr);
+    }
+    return status;
+}
+
 UINT iothub_c2d_receive(bool loop_forever, ULONG wait_ticks) {
-    NX_PACKET *packet_ptr;
     UINT status = 0;
+#ifdef IOTC_ENABLE_RECEIVE_THREAD
+    // The receive thread is the only one dispatching messages, as the message callback is not reentrant.
+    // Just keep the pace of the caller's loop.
+    do {
+        tx_thread_sleep(loop_forever ? NX_IP_PERIODIC_RATE : wait_ticks);
+    } while (loop_forever && is_connected);
+    return NX_AZURE_IOT_NO_PACKET;
+#endif
     if (loop_forever) {
         wait_ticks = NX_WAIT_FOREVER;
     }
 
     /* Loop to receive c2d message.  */
     do {
-    	packet_ptr = NULL;
-        status = nx_azure_iot_hub_client_cloud_message_receive(&iothub_client, &packet_ptr, wait_ticks);
-
-        if ((NX_AZURE_IOT_NO_PACKET != status && NX_SUCCESS != status)) {
-            printf("C2D receive failed!: error code = 0x%08x\r\n", status);
+        status = c2d_receive_one(wait_ticks);
+        if (NX_AZURE_IOT_NO_PACKET != status && NX_SUCCESS != status) {
             break;
         }
-
-        if (NX_SUCCESS == status) {
-            config.c2d_msg_cb( //
-                    packet_ptr->nx_packet_prepend_ptr, //
-                    packet_ptr->nx_packet_append_ptr - packet_ptr->nx_packet_prepend_ptr //
-                            );
-#if 0
-            printf("Received message:");
-            printf_packet(packet_ptr);
-            printf("\r\n");
-#endif
-        }
-        if (packet_ptr) {
-            nx_packet_release(packet_ptr);
-        }
     } while (loop_forever && is_connected);
     return status;
 }
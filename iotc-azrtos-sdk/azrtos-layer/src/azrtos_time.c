@@ -13,6 +13,7 @@
 // Modified by Nik Markovic <nikola.markovic@avnet.com> on 4/19/21.
 //
 
+#include <stdio.h>
 #include <sys/time.h>
 #include "nx_api.h"
 #include "tx_api.h"
@@ -34,13 +35,18 @@
 
 static NX_SNTP_CLIENT   sntp_client;
 
-/* System clock time offset for UTC.  */
-static ULONG            unix_time_base;
+#define MS_PER_DAY (24ULL * 60 * 60 * 1000)
 
+/* System clock time offset for UTC in milliseconds.  */
+static ULONG64          unix_time_base_ms;
+
+// Includes the remainder of the ticks, unlike a conversion to whole seconds
+static ULONG64 system_time_ms(void) {
+    return (ULONG64) tx_time_get() * 1000 / TX_TIMER_TICKS_PER_SECOND;
+}
 
 void set_time(ULONG unix_seconds) {
-	ULONG system_time_in_seconds = tx_time_get() / TX_TIMER_TICKS_PER_SECOND;
-    unix_time_base = (unix_seconds - system_time_in_seconds);
+    unix_time_base_ms = (ULONG64) unix_seconds * 1000 - system_time_ms();
 }
 
 /* Sync up the local time.  */
@@ -125,7 +131,6 @@ UINT    i;
 
             /* Server status is good. Now get the Client local time. */
             ULONG sntp_seconds, sntp_fraction;
-            ULONG system_time_in_second;
 
             /* Get the local time.  */
             status = nx_sntp_client_get_local_time(&sntp_client, &sntp_seconds, &sntp_fraction, NX_NULL);
@@ -136,11 +141,10 @@ UINT    i;
                 continue;
             }
 
-            /* Get the system time in second.  */
-            system_time_in_second = tx_time_get() / TX_TIMER_TICKS_PER_SECOND;
-
-            /* Convert to Unix epoch and minus the current system time.  */
-            unix_time_base = (sntp_seconds - (system_time_in_second + SAMPLE_UNIX_TO_NTP_EPOCH_SECOND));
+            /* Convert to Unix epoch and minus the current system time. The fraction is in units of 1/2^32 seconds. */
+            unix_time_base_ms = (ULONG64) (sntp_seconds - SAMPLE_UNIX_TO_NTP_EPOCH_SECOND) * 1000
+                    + (((ULONG64) sntp_fraction * 1000) >> 32)
+                    - system_time_ms();
             /* Time sync successfully.  */
 
             /* Stop and delete SNTP.  */
@@ -168,11 +172,44 @@ UINT unix_time_get(ULONG *unix_time)
 {
 
     /* Return number of seconds since Unix Epoch (1/1/1970 00:00:00).  */
-    *unix_time =  unix_time_base + (tx_time_get() / TX_TIMER_TICKS_PER_SECOND);
+    *unix_time = (ULONG) ((unix_time_base_ms + system_time_ms()) / 1000);
 
     return(NX_SUCCESS);
 }
 
+UINT unix_time_get_ms(ULONG64 *unix_time_ms) {
+    *unix_time_ms = unix_time_base_ms + system_time_ms();
+    return NX_SUCCESS;
+}
+
+const char *unix_time_format_iso(ULONG64 unix_time_ms, char *buffer, size_t buffer_size) {
+    const ULONG days = (ULONG) (unix_time_ms / MS_PER_DAY);
+    ULONG ms_of_day = (ULONG) (unix_time_ms % MS_PER_DAY);
+
+    // civil date from days since the epoch (proleptic Gregorian calendar)
+    const ULONG z = days + 719468;
+    const ULONG era = z / 146097;
+    const ULONG day_of_era = z - era * 146097;
+    const ULONG year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const ULONG day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const ULONG mp = (5 * day_of_year + 2) / 153;
+    const ULONG day = day_of_year - (153 * mp + 2) / 5 + 1;
+    const ULONG month = mp < 10 ? mp + 3 : mp - 9;
+    const ULONG year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+    const ULONG ms = ms_of_day % 1000;
+    ms_of_day /= 1000;
+    snprintf(buffer, buffer_size, "%04lu-%02lu-%02luT%02lu:%02lu:%02lu.%03luZ",
+            year, month, day, ms_of_day / 3600, (ms_of_day / 60) % 60, ms_of_day % 60, ms);
+    return buffer;
+}
+
+const char *unix_time_iso_now(char *buffer, size_t buffer_size) {
+    ULONG64 now_ms;
+    unix_time_get_ms(&now_ms);
+    return unix_time_format_iso(now_ms, buffer, buffer_size);
+}
+
 #ifdef IOTC_NEEDS_C_TIME
 time_t time(time_t *t) {
 	ULONG time_now;
@@ -192,12 +229,12 @@ int __gettimeofday(struct timeval *tv, void *tzvp) {
 int _gettimeofday(struct timeval *tv, void *tzvp) {
 #endif
     // if either no time, or someone is trying to use timezone offset, we cannot support
-	ULONG time_now;
-    if (NX_SUCCESS != unix_time_get(&time_now)) {
+	ULONG64 time_now_ms;
+    if (NX_SUCCESS != unix_time_get_ms(&time_now_ms)) {
     	return -1;
     }
-    tv->tv_sec = (time_t)time_now;
-    tv->tv_usec = 0L;
+    tv->tv_sec = (time_t)(time_now_ms / 1000);
+    tv->tv_usec = (suseconds_t)((time_now_ms % 1000) * 1000);
     return 0;  // return non-zero for error
 } // end _gettimeofday()
 #endif
@@ -23,8 +23,9 @@ typedef enum {
     UNDEFINED,
     MQTT_CONNECTED,
     MQTT_DISCONNECTED,
-    // MQTT_FAILED, this status is not applicable to AzureRTOS implementation
-    // TODO: Sync statuses etc.
+    MQTT_FAILED,        // IOTC_ENABLE_RECONNECT: gave up reconnecting
+    MQTT_RECONNECTING,  // IOTC_ENABLE_RECONNECT: the connection was lost and the SDK is reconnecting
+    IOTC_SYNCING,       // IOTC_ENABLE_RECONNECT: running discovery and sync again before reconnecting
 } IotConnectConnectionStatus;
 
 typedef enum {
@@ -59,6 +60,26 @@ typedef struct {
     } data;
 } IotConnectAuth;
 
+// Telemetry message property that will be added to the message as application property
+typedef struct {
+    const char *name;
+    const char *value;
+} IotConnectMessageProperty;
+
+// Message properties are added to the telemetry topic, so that IoTHub message routing can use them
+// without parsing the message body. Names and values are plain text and are URL encoded by the SDK.
+// Use iotconnect_sdk_format_message_properties() to encode the properties once and reuse them across messages.
+typedef struct {
+    const IotConnectMessageProperty *items;
+    size_t count;
+    const char *formatted; // URL encoded "name=value&name=value". If set, items are ignored.
+    size_t formatted_len;
+} IotConnectMessageProperties;
+
+// IoTHub system properties
+#define IOTC_PROPERTY_CONTENT_TYPE      "$.ct"
+#define IOTC_PROPERTY_CONTENT_ENCODING  "$.ce"
+
 typedef struct {
     char *env;    // Environment name. Contact your representative for details.
     char *cpid;   // Settings -> Company Profile.
@@ -83,17 +104,70 @@ IotclConfig *iotconnect_sdk_get_lib_config();
 
 void iotconnect_sdk_send_packet(const char *data);
 
+// Sends len bytes of data as-is. The data does not need to be null terminated and can be binary.
+// properties can be NULL.
+UINT iotconnect_sdk_send_packet_n(const void *data, size_t len, const IotConnectMessageProperties *properties);
+
+// Encodes the property items into buffer and sets properties->formatted to point to it.
+// The buffer must remain valid while the properties are in use. Returns NX_SIZE_ERROR if the buffer is too small.
+UINT iotconnect_sdk_format_message_properties(IotConnectMessageProperties *properties, char *buffer, size_t buffer_size);
+
+typedef enum {
+    IOTC_QOS_AT_MOST_ONCE = 0, // fire-and-forget. Best for high rate, loss-tolerant streams.
+    IOTC_QOS_AT_LEAST_ONCE = 1 // waits for PUBACK. Default for iotconnect_sdk_send_packet(), unless overridden in Azure IoT config.
+} IotConnectQos;
+
+// Same as iotconnect_sdk_send_packet_n(), but with the given MQTT QoS.
+// QoS 0 messages are not retained by the offline queue and are dropped if the packet pool is exhausted.
+UINT iotconnect_sdk_send_packet_qos(const void *data, size_t len, const IotConnectMessageProperties *properties,
+        IotConnectQos qos);
+
+#ifdef IOTC_ENABLE_SEND_QUEUE
+// Called from the SDK publisher thread once the queued message is sent or the send fails.
+typedef void (*IotConnectSendCallback)(void *context, UINT status);
+
+// Copies the null terminated message into the send queue and returns immediately.
+// The message will be sent by the SDK publisher thread once we are connected.
+// Returns NX_OVERFLOW if the queue is full. The callback is optional.
+UINT iotconnect_sdk_send_packet_async(const char *data, IotConnectSendCallback cb, void *cb_context);
+
+typedef enum {
+    IOTC_PRIORITY_BULK = 0,
+    IOTC_PRIORITY_CRITICAL  // always sent ahead of any queued bulk messages
+} IotConnectSendPriority;
+
+// Same as iotconnect_sdk_send_packet_async(), but for binary data and with the given priority.
+// The properties are not copied and must remain valid until the callback is invoked.
+UINT iotconnect_sdk_send_packet_async_n(const void *data, size_t len, const IotConnectMessageProperties *properties,
+        IotConnectSendPriority priority, IotConnectSendCallback cb, void *cb_context);
+#endif // IOTC_ENABLE_SEND_QUEUE
+
 // Receive loop hook forever-blocking for for C2D messages.
 // Either call this function, or IoTConnectSdk_Poll()
+// Returns once disconnected (and, with IOTC_ENABLE_RECONNECT, once the SDK stops reconnecting).
+// It calls iotconnect_sdk_poll() every IOTC_RECEIVE_LOOP_INTERVAL_MS, so everything that the poll runs is serviced.
 void iotconnect_sdk_receive();
 
 // Receive poll hook for for C2D messages.
 // Either call this function, or IotConnectSdk_Receive()
 // Set wait_time to a multiple of NX_IP_PERIODIC_RATE
+// Sync requested by the cloud (ON_FORCE_SYNC) runs from this function, while the connection is kept.
+// The SDK reconnects only if the IoTHub host or client ID changed. Otherwise the new DTG is simply applied.
+// With IOTC_ENABLE_BACKGROUND_SYNC, the HTTPS requests of the sync run on an SDK thread instead, so that this
+// function does not block on them. The result is still applied from this function.
+// With IOTC_ENABLE_RECEIVE_THREAD, C2D messages are handled by the SDK receive thread as soon as they arrive
+// and the command/OTA callbacks are called from that thread. This function then only services the other
+// SDK features and sleeps for wait_time_ms.
+// With IOTC_ENABLE_RECONNECT, discovery and sync needed by a reconnect also run from this function.
 void iotconnect_sdk_poll(UINT wait_time_ms);
 
 void iotconnect_sdk_disconnect();
 
+// Connects to IoTHub again after the connection was lost. If resync is true, or the client was released,
+// discovery and sync are run again first, in case the device was moved to a different IoTHub.
+// With IOTC_ENABLE_RECONNECT, the SDK does this automatically. See iotconnect_reconnect.h.
+UINT iotconnect_sdk_reconnect(bool resync);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,85 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_BATCH_H
+#define IOTCONNECT_BATCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_TELEMETRY_BATCH compile flag.
+
+The batching layer accumulates telemetry records and sends them as a single IoTConnect message
+with multiple data points, instead of sending one MQTT message per record.
+The batch is flushed when the record count, byte budget or max latency limit is reached,
+whichever comes first, or when iotc_batch_flush() is called explicitly.
+
+The batch is built in a static buffer of IOTC_BATCH_BUFFER_SIZE (2k by default) and
+each record is composed in a static buffer of IOTC_BATCH_RECORD_BUFFER_SIZE (256 bytes by default).
+Both can be overridden with compile-time defines.
+
+If IOTC_ENABLE_SEND_QUEUE is also enabled, flushed batches are handed off to the send queue.
+
+Usage:
+    iotc_batch_record_begin(NULL);
+    iotc_batch_set_number("temperature", 22.5);
+    iotc_batch_set_string("status", "OK");
+    iotc_batch_record_end();
+
+The calls between iotc_batch_record_begin() and iotc_batch_record_end() must be made from the same thread
+and only one thread may build a record at a time. If an iotc_batch_set_*() call fails, the application
+can simply return; the unfinished record is discarded by iotc_batch_record_abort() or the next iotc_batch_record_begin().
+The max latency limit is evaluated on every iotc_batch_record_end() and iotconnect_sdk_poll() call,
+or the application can call iotc_batch_poll() from its own thread.
+*/
+
+#ifdef IOTC_ENABLE_TELEMETRY_BATCH
+
+typedef struct {
+    UINT max_records;       // Flush once this many records are in the batch. 0 means no limit.
+    size_t max_bytes;       // Flush before the message would exceed this size. 0 means IOTC_BATCH_BUFFER_SIZE.
+    UINT max_latency_ms;    // Flush once the oldest record in the batch is this old. 0 means no limit.
+} IotConnectBatchConfig;
+
+// Safe to call more than once in order to change the configuration. Any pending records will be flushed.
+UINT iotc_batch_init(const IotConnectBatchConfig *config);
+
+// Starts a new record. If iso_time is NULL, the current time will be used.
+bool iotc_batch_record_begin(const char *iso_time);
+
+bool iotc_batch_set_number(const char *name, double value);
+
+bool iotc_batch_set_string(const char *name, const char *value);
+
+bool iotc_batch_set_bool(const char *name, bool value);
+
+bool iotc_batch_set_null(const char *name);
+
+// Discards the record started with iotc_batch_record_begin(), if any.
+void iotc_batch_record_abort(void);
+
+// Completes the record and adds it to the batch. The batch may be sent if any of the limits are reached.
+// Returns NX_SIZE_ERROR if the record cannot fit into the record buffer or the batch.
+// If sending the previous batch failed in order to make room for this record, that error is returned.
+UINT iotc_batch_record_end(void);
+
+// Sends all pending records now.
+UINT iotc_batch_flush(void);
+
+// Sends pending records if the max latency limit is reached.
+UINT iotc_batch_poll(void);
+
+#endif // IOTC_ENABLE_TELEMETRY_BATCH
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_BATCH_H
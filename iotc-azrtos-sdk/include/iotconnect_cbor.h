@@ -0,0 +1,101 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_CBOR_H
+#define IOTCONNECT_CBOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "iotconnect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_CBOR compile flag.
+
+A compact binary (CBOR, RFC 8949) alternative to the JSON telemetry messages produced by
+iotcl_create_serialized_string(). The message has the same structure and keys as the JSON message,
+but numbers are sent in binary form and no heap allocations are made - the message is encoded
+directly into a caller provided buffer.
+
+The calls mirror the iotcl_telemetry_* calls, so switching an application is mostly a matter of renaming:
+
+    UCHAR buffer[512];
+    IotcCborTelemetry t;
+    iotc_cbor_telemetry_create(&t, buffer, sizeof(buffer));
+    iotc_cbor_telemetry_add_with_iso_time(&t, NULL);
+    iotc_cbor_telemetry_set_number(&t, "temperature", 22.5);
+    iotc_cbor_telemetry_set_string(&t, "status", "OK");
+    size_t len = iotc_cbor_telemetry_finish(&t);
+    if (len) {
+        iotconnect_sdk_send_packet_n(buffer, len, &iotc_cbor_message_properties);
+    }
+*/
+
+#ifdef IOTC_ENABLE_CBOR
+
+// Low level encoder. Maps and arrays are encoded with indefinite length, so the number of items
+// does not need to be known up front. Once the buffer overflows, all subsequent calls are ignored.
+typedef struct {
+    UCHAR *buffer;
+    size_t size;
+    size_t len;
+    bool overflow;
+} IotcCborWriter;
+
+void iotc_cbor_init(IotcCborWriter *w, void *buffer, size_t size);
+
+void iotc_cbor_map_begin(IotcCborWriter *w);
+
+void iotc_cbor_array_begin(IotcCborWriter *w);
+
+// Ends the most recent map or array
+void iotc_cbor_end(IotcCborWriter *w);
+
+void iotc_cbor_text(IotcCborWriter *w, const char *str);
+
+void iotc_cbor_int(IotcCborWriter *w, long long value);
+
+// Encodes the value as an integer, single or double precision float - whichever is shortest without losing precision
+void iotc_cbor_number(IotcCborWriter *w, double value);
+
+void iotc_cbor_bool(IotcCborWriter *w, bool value);
+
+void iotc_cbor_null(IotcCborWriter *w);
+
+// IoTConnect telemetry message
+typedef struct {
+    IotcCborWriter w;
+    bool in_record;
+} IotcCborTelemetry;
+
+bool iotc_cbor_telemetry_create(IotcCborTelemetry *t, void *buffer, size_t size);
+
+// Starts a new data point. If iso_time is NULL, the current time will be used.
+bool iotc_cbor_telemetry_add_with_iso_time(IotcCborTelemetry *t, const char *iso_time);
+
+bool iotc_cbor_telemetry_set_number(IotcCborTelemetry *t, const char *name, double value);
+
+bool iotc_cbor_telemetry_set_string(IotcCborTelemetry *t, const char *name, const char *value);
+
+bool iotc_cbor_telemetry_set_bool(IotcCborTelemetry *t, const char *name, bool value);
+
+bool iotc_cbor_telemetry_set_null(IotcCborTelemetry *t, const char *name);
+
+// Completes the message. Returns the encoded length, or 0 if the message did not fit into the buffer.
+size_t iotc_cbor_telemetry_finish(IotcCborTelemetry *t);
+
+// Pass these to iotconnect_sdk_send_packet_n() so that the message is tagged with the CBOR content type
+extern const IotConnectMessageProperties iotc_cbor_message_properties;
+
+#endif // IOTC_ENABLE_CBOR
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_CBOR_H
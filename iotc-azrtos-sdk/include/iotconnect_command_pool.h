@@ -0,0 +1,70 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_COMMAND_POOL_H
+#define IOTCONNECT_COMMAND_POOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "iotconnect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_COMMAND_POOL compile flag and call iotc_command_pool_init()
+before iotconnect_sdk_init().
+
+Commands and OTA requests are handed to a pool of IOTC_COMMAND_POOL_WORKERS worker threads (2 by default)
+through a queue of IOTC_COMMAND_POOL_QUEUE_SIZE entries, instead of running the cmd_cb and ota_cb callbacks
+on the thread that receives the messages. A firmware download or a long actuation then does not hold up
+the reception of other commands and messages.
+
+The callbacks own the event data just like without the pool, so they should send the ack
+(iotcl_create_ack_string_and_destroy_event()) once the work is done. If the queue is full, the SDK sends
+a failure ack for the command right away.
+
+The number of concurrently running commands can be limited per command name. The name is the first word
+of the command text, or IOTC_COMMAND_POOL_OTA for OTA requests. A command that is at its limit waits in the queue,
+while the other commands can still run.
+
+Each worker has its own stack of IOTC_COMMAND_POOL_STACK_SIZE bytes (6 KB by default). Since the callbacks,
+including the OTA download, run on the workers, set it to at least the stack size of the thread that calls
+iotconnect_sdk_init() in your application, like SAMPLE_HELPER_STACK_SIZE in the samples.
+*/
+
+#ifdef IOTC_ENABLE_COMMAND_POOL
+
+#define IOTC_COMMAND_POOL_OTA "ota"
+
+typedef struct {
+    const char *command;    // command name, or IOTC_COMMAND_POOL_OTA
+    UINT max_concurrent;    // 0 means no limit
+} IotConnectCommandLimit;
+
+typedef struct {
+    const IotConnectCommandLimit *limits;
+    size_t limit_count;
+    UINT default_max_concurrent; // Limit for the commands that are not in limits. 0 means no limit.
+} IotConnectCommandPoolConfig;
+
+// Safe to call more than once in order to change the limits. The limits are not copied.
+UINT iotc_command_pool_init(const IotConnectCommandPoolConfig *config);
+
+bool iotc_command_pool_is_enabled(void);
+
+// Queues the event for the callback to be called from a worker thread
+UINT iotc_command_pool_submit_command(IotclEventData data, IotclCommandCallback cb);
+
+UINT iotc_command_pool_submit_ota(IotclEventData data, IotclOtaCallback cb);
+
+#endif // IOTC_ENABLE_COMMAND_POOL
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_COMMAND_POOL_H
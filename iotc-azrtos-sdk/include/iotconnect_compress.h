@@ -0,0 +1,57 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_COMPRESS_H
+#define IOTCONNECT_COMPRESS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "azrtos_iothub_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_COMPRESSION compile flag and call iotc_compress_init().
+
+Telemetry messages of min_size bytes or more are gzip compressed while they are written into the telemetry packet,
+and the content encoding message property is set to "gzip", so that the consumers know to decompress the body.
+JSON telemetry, especially batched, typically shrinks 3-5 times.
+
+The compressor is a single pass LZ77 matcher with fixed Huffman codes. It only needs a static hash table of
+(1 << IOTC_COMPRESS_HASH_BITS) positions (4k by default) and no output buffer, as the whole message is already
+in memory and the output goes straight into the packet. Messages that would not get smaller are sent as they are.
+Messages that already have a content encoding property and messages sent with a non-default QoS are not compressed.
+*/
+
+#ifdef IOTC_ENABLE_COMPRESSION
+
+#define IOTC_COMPRESS_CONTENT_ENCODING "gzip"
+
+typedef struct {
+    size_t min_size; // Messages smaller than this are not compressed. 0 means IOTC_COMPRESS_DEFAULT_MIN_SIZE.
+} IotConnectCompressConfig;
+
+// Safe to call more than once in order to change the configuration.
+UINT iotc_compress_init(const IotConnectCompressConfig *config);
+
+// Returns true if the message should be compressed before sending.
+bool iotc_compress_should_compress(size_t len, const IotConnectMessageProperties *properties);
+
+// Compresses data in gzip format into the buffer. Returns NX_SIZE_ERROR if the result does not fit.
+UINT iotc_compress_gzip(const void *data, size_t len, void *buffer, size_t buffer_size, size_t *compressed_len);
+
+// Compresses data in gzip format into the telemetry packet.
+// Returns NX_SIZE_ERROR if the result would not be smaller than len. The packet is not released.
+UINT iotc_compress_gzip_packet(const void *data, size_t len, IotConnectTelemetryPacket *tp, size_t *compressed_len);
+
+#endif // IOTC_ENABLE_COMPRESSION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_COMPRESS_H
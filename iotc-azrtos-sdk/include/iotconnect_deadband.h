@@ -0,0 +1,104 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_DEADBAND_H
+#define IOTCONNECT_DEADBAND_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "iotconnect_json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Change-based telemetry suppression for slow moving values.
+
+Each attribute has an absolute and/or percent deadband around the value that was last sent.
+A new value is significant only if it moves outside of all configured deadbands.
+With no deadband configured, any change is significant. Suppressed values are not lost:
+the latest value is always retained and it is sent with the next message that goes out.
+An attribute is also sent once it has not been sent for max_silence_ms (heartbeat).
+
+    static IotcDeadbandAttribute attributes[] = {
+        IOTC_DEADBAND_ATTRIBUTE("temperature", 0.5, 0),
+        IOTC_DEADBAND_ATTRIBUTE("pressure", 0, 1.0), // 1%
+    };
+    static IotcDeadbandFilter filter = IOTC_DEADBAND_FILTER(attributes, 15 * 60 * 1000);
+
+    iotc_deadband_update(&filter, 0, temperature);
+    iotc_deadband_update(&filter, 1, pressure);
+    if (iotc_deadband_should_send(&filter)) {
+        ... iotc_json_telemetry_record_begin(&w, NULL);
+        iotc_deadband_write(&filter, &w);
+        ... send
+        if (send succeeded) {
+            iotc_deadband_commit(&filter);
+        }
+    }
+
+The attributes that go into the message are selected when the message is written, and they are only marked
+as sent by iotc_deadband_commit(). If the send fails, simply skip the commit and the values will be selected
+again for the next message.
+Applications using iotcl_telemetry_* can call iotc_deadband_select() instead of iotc_deadband_write(),
+then use iotc_deadband_is_selected() for each attribute and call iotc_deadband_commit() once the message is sent.
+The filter is not thread safe.
+*/
+
+typedef struct {
+    const char *name;
+    double absolute;            // 0 means no absolute deadband
+    double percent;             // 0 means no percent deadband. Relative to the last sent value.
+
+    // state
+    double last_sent;
+    double latest;
+    ULONG last_sent_ticks;
+    ULONG suppressed_count;     // number of updates that were suppressed since the last send
+    double selected_value;      // the value that went into the message that is not committed yet
+    bool has_value;
+    bool has_sent;
+    bool is_significant;
+    bool is_selected;
+} IotcDeadbandAttribute;
+
+typedef struct {
+    IotcDeadbandAttribute *attributes;
+    size_t count;
+    ULONG max_silence_ms;       // 0 means no heartbeat
+    ULONG selected_ticks;       // when the selection was made
+} IotcDeadbandFilter;
+
+#define IOTC_DEADBAND_ATTRIBUTE(name, absolute, percent) { (name), (absolute), (percent) }
+
+#define IOTC_DEADBAND_FILTER(attributes, max_silence_ms) \
+    { (attributes), sizeof(attributes) / sizeof((attributes)[0]), (max_silence_ms) }
+
+// Records the latest value of the attribute at index. Returns true if the value is significant.
+bool iotc_deadband_update(IotcDeadbandFilter *f, size_t index, double value);
+
+// Returns true if any attribute has a significant change or a heartbeat is due
+bool iotc_deadband_should_send(IotcDeadbandFilter *f);
+
+// Selects the attributes for the next message and takes a snapshot of their values. Returns the number selected.
+// Any previous selection that was not committed is replaced.
+size_t iotc_deadband_select(IotcDeadbandFilter *f);
+
+// Returns true if the attribute was selected by the last iotc_deadband_select() or iotc_deadband_write()
+bool iotc_deadband_is_selected(IotcDeadbandFilter *f, size_t index);
+
+// Marks the selected attributes as sent. Call only once the message was sent successfully.
+void iotc_deadband_commit(IotcDeadbandFilter *f);
+
+// Selects the attributes and writes them as number values. Returns the number of values written,
+// or 0 if the writer overflowed. Call iotc_deadband_commit() once the message is sent.
+size_t iotc_deadband_write(IotcDeadbandFilter *f, IotcJsonWriter *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_DEADBAND_H
@@ -0,0 +1,102 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_JSON_WRITER_H
+#define IOTCONNECT_JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "azrtos_iothub_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Streaming JSON writer that emits IoTConnect telemetry messages without any heap allocations.
+The output can go either into a caller provided buffer, or directly into a telemetry NX_PACKET
+(see iothub_telemetry_packet_create()), so that no intermediate copy of the message is needed.
+
+The writer takes care of commas between values. Once the output overflows, all subsequent calls are ignored
+and the overflow flag remains set.
+
+    IotConnectTelemetryPacket tp;
+    IotcJsonWriter w;
+    if (!iothub_telemetry_packet_create(&tp, NULL)) {
+        iotc_json_init_packet(&w, &tp);
+        iotc_json_telemetry_begin(&w);
+        iotc_json_telemetry_record_begin(&w, NULL);
+        iotc_json_set_number(&w, "temperature", 22.5);
+        iotc_json_set_string(&w, "status", "OK");
+        iotc_json_telemetry_record_end(&w);
+        iotc_json_telemetry_end(&w);
+        iothub_telemetry_packet_send(&tp); // will fail with the write error, if any
+    }
+*/
+
+typedef struct {
+    char *buffer; // buffer mode only
+    size_t size;
+    size_t len;
+    IotConnectTelemetryPacket *tp; // packet mode only
+    bool need_comma;
+    bool overflow;
+} IotcJsonWriter;
+
+// The buffer is always kept null terminated, so size - 1 bytes are available for the JSON text
+void iotc_json_init_buffer(IotcJsonWriter *w, char *buffer, size_t size);
+
+void iotc_json_init_packet(IotcJsonWriter *w, IotConnectTelemetryPacket *tp);
+
+// Appends text as-is. The caller is responsible for commas and validity.
+void iotc_json_raw(IotcJsonWriter *w, const char *str, size_t len);
+
+void iotc_json_object_begin(IotcJsonWriter *w);
+
+void iotc_json_object_end(IotcJsonWriter *w);
+
+void iotc_json_array_begin(IotcJsonWriter *w);
+
+void iotc_json_array_end(IotcJsonWriter *w);
+
+void iotc_json_key(IotcJsonWriter *w, const char *name);
+
+// Same as iotc_json_key(), but the key is already quoted and followed by a colon. Eg: "\"temperature\":"
+void iotc_json_key_raw(IotcJsonWriter *w, const char *quoted_key, size_t len);
+
+void iotc_json_string(IotcJsonWriter *w, const char *str);
+
+// Prints the number the same way as cJSON would. NaN and infinity are printed as null.
+void iotc_json_number(IotcJsonWriter *w, double value);
+
+void iotc_json_bool(IotcJsonWriter *w, bool value);
+
+void iotc_json_null(IotcJsonWriter *w);
+
+// key-value helpers
+bool iotc_json_set_number(IotcJsonWriter *w, const char *name, double value);
+
+bool iotc_json_set_string(IotcJsonWriter *w, const char *name, const char *value);
+
+bool iotc_json_set_bool(IotcJsonWriter *w, const char *name, bool value);
+
+bool iotc_json_set_null(IotcJsonWriter *w, const char *name);
+
+// IoTConnect telemetry envelope. Requires iotcl_init() to be called first.
+// Writes everything up to and including the data point array opening.
+bool iotc_json_telemetry_begin(IotcJsonWriter *w);
+
+// Starts a data point. If iso_time is NULL, the current time will be used.
+bool iotc_json_telemetry_record_begin(IotcJsonWriter *w, const char *iso_time);
+
+bool iotc_json_telemetry_record_end(IotcJsonWriter *w);
+
+bool iotc_json_telemetry_end(IotcJsonWriter *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_JSON_WRITER_H
@@ -0,0 +1,77 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_OFFLINE_H
+#define IOTCONNECT_OFFLINE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "iotconnect.h"
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+#include "fx_api.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_OFFLINE_QUEUE compile flag.
+
+Store-and-forward queue for telemetry that cannot be sent while we are disconnected.
+When iotconnect_sdk_send_packet() or iotconnect_sdk_send_packet_n() is called while IoTHub is not connected,
+or the send fails, the message is stored in a RAM ring buffer of IOTC_OFFLINE_BUFFER_SIZE bytes (4k by default)
+instead of being discarded. The messages already carry their timestamps, so they are sent as they were
+originally composed once the connection is back.
+
+If IOTC_ENABLE_OFFLINE_FILEX is also set and a FileX media is provided, iotconnect_sdk_poll() moves the oldest messages
+from the RAM buffer into a file once the RAM buffer is more than IOTC_OFFLINE_SPILL_THRESHOLD bytes full
+(half of it by default), so that hours of data can be retained. The media is only accessed by the thread
+that calls iotconnect_sdk_poll(), so sending telemetry never waits for it. If the RAM buffer fills up
+before the next poll, the oldest messages are discarded.
+The moved messages are flushed to the media right away, so only the messages in the RAM buffer are lost on a power loss.
+The file keeps track of the messages that were already sent, so the backlog survives a reboot.
+To reduce flash wear, this progress is synced to the media at most every IOTC_OFFLINE_FILE_SYNC_INTERVAL_MS
+(10 seconds by default), so the messages sent within that interval may be sent again after a power loss.
+
+The backlog is sent from iotconnect_sdk_poll(), oldest messages first, at no more than
+drain_messages_per_second messages and IOTC_OFFLINE_DRAIN_MAX_MESSAGES messages per poll call.
+New messages are sent directly while the backlog is drained.
+
+Message properties are stored with the message in their encoded form, so they do not need to outlive the call.
+*/
+
+#ifdef IOTC_ENABLE_OFFLINE_QUEUE
+
+typedef struct {
+    UINT drain_messages_per_second; // Rate limit for sending the backlog. 0 means no limit.
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+    FX_MEDIA *media;                // Media to store the overflow file on. NULL means RAM only.
+    CHAR *file_name;                // Defaults to IOTC_OFFLINE_DEFAULT_FILE_NAME
+    ULONG max_file_size;            // Messages are discarded once the file reaches this size. 0 means no limit.
+#endif
+} IotConnectOfflineConfig;
+
+UINT iotc_offline_init(const IotConnectOfflineConfig *config);
+
+bool iotc_offline_is_enabled(void);
+
+// Copies the message and its properties (can be NULL) into the backlog.
+// If the backlog is full, the oldest message is discarded.
+UINT iotc_offline_store(const void *data, size_t len, const IotConnectMessageProperties *properties);
+
+// Sends some of the backlog if we are connected. Called by iotconnect_sdk_poll().
+UINT iotc_offline_drain(void);
+
+// Number of messages in the backlog
+ULONG iotc_offline_count(void);
+
+#endif // IOTC_ENABLE_OFFLINE_QUEUE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_OFFLINE_H
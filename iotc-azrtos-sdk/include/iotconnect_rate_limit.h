@@ -0,0 +1,80 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_RATE_LIMIT_H
+#define IOTCONNECT_RATE_LIMIT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_RATE_LIMIT compile flag.
+
+Token bucket rate limiter for all telemetry sent by the SDK, so that bursts (like draining a backlog)
+stay within the IoTHub tier throttling limits instead of getting the device disconnected.
+Messages and bytes are limited independently. Either limit can be disabled by setting its rate to 0.
+
+What happens when there are not enough tokens depends on the policy:
+- IOTC_RATE_LIMIT_BLOCK: The sending thread waits up to block_timeout_ms for the tokens,
+  then the message is dropped.
+- IOTC_RATE_LIMIT_DROP_NEWEST: The message being sent is dropped.
+  The send queue waits for the tokens, and a new message is rejected if the queue overflows while waiting.
+- IOTC_RATE_LIMIT_DROP_OLDEST: Only for the send queue (IOTC_ENABLE_SEND_QUEUE), which waits for the tokens,
+  and when it overflows while waiting, drops the oldest queued messages to make room for the new one.
+  There is no older message to drop when sending directly, so direct sends fail with NX_NOT_SUPPORTED.
+- IOTC_RATE_LIMIT_DEFER: The message is handed to the offline queue (IOTC_ENABLE_OFFLINE_QUEUE)
+  and will be sent when iotconnect_sdk_poll() drains it. Dropped if the offline queue is not enabled.
+
+The send queue publisher thread and the offline queue drain always wait for the tokens rather than dropping.
+Messages that go to the offline queue because we are disconnected do not take any tokens.
+*/
+
+#ifdef IOTC_ENABLE_RATE_LIMIT
+
+typedef enum {
+    IOTC_RATE_LIMIT_BLOCK = 0,
+    IOTC_RATE_LIMIT_DROP_OLDEST,
+    IOTC_RATE_LIMIT_DEFER,
+    IOTC_RATE_LIMIT_DROP_NEWEST
+} IotConnectRateLimitPolicy;
+
+typedef struct {
+    UINT messages_per_second;   // 0 means no message limit
+    UINT burst_messages;        // Bucket size. 0 means same as messages_per_second.
+    ULONG bytes_per_second;     // 0 means no byte limit
+    ULONG burst_bytes;          // Bucket size. 0 means same as bytes_per_second.
+    IotConnectRateLimitPolicy policy;
+    ULONG block_timeout_ms;     // Used with IOTC_RATE_LIMIT_BLOCK
+} IotConnectRateLimitConfig;
+
+// Safe to call more than once in order to change the configuration. The bucket starts full.
+UINT iotc_rate_limit_init(const IotConnectRateLimitConfig *config);
+
+IotConnectRateLimitPolicy iotc_rate_limit_get_policy(void);
+
+// Takes the tokens for a message of len bytes if they are available now.
+// Otherwise returns NX_NO_MORE_ENTRIES and sets *ticks_needed to the time until they will be available.
+UINT iotc_rate_limit_try_acquire(size_t len, ULONG *ticks_needed);
+
+// Takes the tokens for a message of len bytes, waiting up to wait_ticks for them.
+// Returns NX_NO_MORE_ENTRIES if the tokens are not available in time.
+// Always succeeds if the limiter is not initialized.
+UINT iotc_rate_limit_acquire(size_t len, ULONG wait_ticks);
+
+// Takes the tokens according to the configured policy for a message that is sent directly by the caller.
+// Returns NX_NOT_SUPPORTED with the IOTC_RATE_LIMIT_DROP_OLDEST policy.
+UINT iotc_rate_limit_admit(size_t len);
+
+#endif // IOTC_ENABLE_RATE_LIMIT
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_RATE_LIMIT_H
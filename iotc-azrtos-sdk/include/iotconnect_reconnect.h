@@ -0,0 +1,86 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_RECONNECT_H
+#define IOTCONNECT_RECONNECT_H
+
+#include <stdbool.h>
+#include "tx_api.h"
+#include "iotconnect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_RECONNECT compile flag and call iotc_reconnect_init()
+before iotconnect_sdk_init().
+
+When the IoTHub connection is lost, the SDK reconnects from its own thread instead of leaving it to the application.
+The application gets MQTT_RECONNECTING instead of MQTT_DISCONNECTED, then MQTT_CONNECTED once the connection
+is back, so it can simply keep running while iotconnect_sdk_is_connected() returns false.
+
+The disconnect reason decides what happens next:
+- An expired SAS token: reconnect right away. A new token is generated on connect.
+- Rejected credentials (bad user name/password or not authorized): run discovery and sync again,
+  as the device may have been moved to a different IoTHub. The application gets IOTC_SYNCING.
+  Discovery and sync replace the settings that the rest of the SDK uses, so they do not run on the reconnect thread.
+  The next iotconnect_sdk_poll() on the application thread runs them. Keep calling it while disconnected.
+- Anything else (network loss, server unavailable): reconnect the MQTT client after a backoff delay.
+  After sync_after_attempts failed attempts, discovery and sync are run again as well.
+
+The backoff delay of an attempt is random between initial_delay_ms and twice the previous upper limit,
+so that a device waits initial_delay_ms..2*initial_delay_ms before the first attempt, then up to 4*initial_delay_ms
+and so on, up to max_delay_ms. The randomness spreads out the reconnects of devices that lost their connection
+at the same time, like when an IoTHub fails over. It is based on rand(), so seed it with srand() and a hardware
+random number at startup, like the samples do. Otherwise all devices will pick the same delays.
+
+After max_attempts failed attempts, the SDK gives up and reports MQTT_FAILED.
+iotconnect_sdk_disconnect() stops any reconnect in progress.
+*/
+
+#ifdef IOTC_ENABLE_RECONNECT
+
+typedef struct {
+    UINT initial_delay_ms;      // 0 means IOTC_RECONNECT_DEFAULT_INITIAL_DELAY_MS
+    UINT max_delay_ms;          // 0 means IOTC_RECONNECT_DEFAULT_MAX_DELAY_MS
+    UINT max_attempts;          // 0 means retry forever
+    UINT sync_after_attempts;   // run discovery and sync after this many failed attempts. 0 means never.
+} IotConnectReconnectConfig;
+
+typedef enum {
+    IOTC_RECONNECT_IDLE = 0,    // connected, or the disconnect was requested
+    IOTC_RECONNECT_WAITING,     // waiting for the backoff delay
+    IOTC_RECONNECT_CONNECTING,
+    IOTC_RECONNECT_SYNCING,
+    IOTC_RECONNECT_FAILED       // gave up after max_attempts
+} IotConnectReconnectState;
+
+// Safe to call more than once in order to change the settings
+UINT iotc_reconnect_init(const IotConnectReconnectConfig *config);
+
+bool iotc_reconnect_is_enabled(void);
+
+// Called by the SDK when the connection is lost. Returns true if the reconnect engine is handling it.
+// status_cb receives the state transitions.
+bool iotc_reconnect_start(UINT reason, IotConnectStatusCallback status_cb);
+
+// Stops any reconnect in progress. Waits for the attempt that is in progress to complete.
+void iotc_reconnect_cancel(void);
+
+// Called by iotconnect_sdk_poll(). Returns true if the reconnect thread is waiting for the application thread
+// to run an attempt with iotconnect_sdk_reconnect(resync). Report the result with iotc_reconnect_attempt_done().
+bool iotc_reconnect_take_pending_attempt(bool *resync);
+
+void iotc_reconnect_attempt_done(UINT status);
+
+IotConnectReconnectState iotc_reconnect_get_state(void);
+
+#endif // IOTC_ENABLE_RECONNECT
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_RECONNECT_H
@@ -0,0 +1,58 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_RECORD_RING_H
+#define IOTCONNECT_RECORD_RING_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+A ring buffer of variable length records stored in a caller provided buffer.
+Each record is stored contiguously, so that a pointer to the oldest record can be handed directly
+to the network layer without copying it first.
+If a record doesn't fit at the end of the buffer, the ring will wrap and store it at the start of the buffer.
+
+The ring is not thread safe. The caller is responsible for locking.
+*/
+
+typedef struct {
+    UCHAR *buffer;
+    size_t size;
+    size_t head;    // offset of the oldest record
+    size_t tail;    // offset where the next record will be written
+    size_t end;     // end of valid data in the top part of the buffer after a wrap
+    UINT count;     // number of records in the ring
+} IotcRecordRing;
+
+// The buffer should be ULONG aligned. Any trailing bytes not aligned to ULONG are not used.
+void iotc_record_ring_init(IotcRecordRing *ring, void *buffer, size_t size);
+
+// Reserves a contiguous block for a new record of record_size bytes and returns a pointer to it.
+// Returns NULL if the ring is full. The record is stored and counted immediately.
+void *iotc_record_ring_push(IotcRecordRing *ring, size_t record_size);
+
+// Returns the oldest record and its (ULONG aligned) size or NULL if the ring is empty.
+void *iotc_record_ring_peek(IotcRecordRing *ring, size_t *record_size);
+
+// Discards the oldest record.
+void iotc_record_ring_pop(IotcRecordRing *ring);
+
+static inline UINT iotc_record_ring_count(IotcRecordRing *ring) {
+    return ring->count;
+}
+
+// Number of bytes taken by the records, including their size prefixes and any padding
+size_t iotc_record_ring_used(IotcRecordRing *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_RECORD_RING_H
@@ -0,0 +1,96 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_SAMPLER_H
+#define IOTCONNECT_SAMPLER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#include "iotconnect_json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_SAMPLER compile flag.
+
+Sensor acquisition decoupled from the network. A dedicated sampler thread calls read_cb at rate_hz
+and pushes the values into a lock-free single producer/single consumer ring of IOTC_SAMPLER_RING_SIZE samples.
+The sampler never blocks: if the consumer falls behind, samples are dropped and counted.
+
+The consumer (usually the thread that publishes telemetry) calls iotc_sampler_poll() often enough to keep
+the ring from filling up (64 samples by default, so every 0.5 seconds at 100 Hz). The samples are aggregated
+into min/max/mean/stddev/count per channel over windows of window_ms, based on the time the sample was taken.
+iotc_sampler_poll() returns true when a window is complete. The stats of the completed window remain available
+until the next window is completed.
+
+    static const char *names[] = { "accelerometer.x", "accelerometer.y", "accelerometer.z" };
+    IotcSamplerConfig config = {
+        .channel_names = names, .channel_count = 3, .rate_hz = 100, .window_ms = 10000, .read_cb = read_accel
+    };
+    iotc_sampler_start(&config);
+    ...
+    if (iotc_sampler_poll()) {
+        ... iotc_json_telemetry_record_begin(&w, NULL);
+        iotc_sampler_write(&w);
+        ... send
+    }
+*/
+
+#ifdef IOTC_ENABLE_SAMPLER
+
+#ifndef IOTC_SAMPLER_MAX_CHANNELS
+#define IOTC_SAMPLER_MAX_CHANNELS (12)
+#endif
+
+// Reads one sample of channel_count values. Return false if the read failed and the sample should be skipped.
+// Called from the sampler thread.
+typedef bool (*IotcSamplerReadCallback)(void *context, float *values);
+
+typedef struct {
+    const char **channel_names; // Dotted names are written as object attributes. Eg. "accelerometer.x"
+    UINT channel_count;         // up to IOTC_SAMPLER_MAX_CHANNELS
+    UINT rate_hz;               // Up to TX_TIMER_TICKS_PER_SECOND
+    UINT window_ms;
+    IotcSamplerReadCallback read_cb;
+    void *cb_context;
+} IotcSamplerConfig;
+
+typedef struct {
+    ULONG count;
+    double min;
+    double max;
+    double mean;
+    double stddev;
+} IotcSamplerStats;
+
+UINT iotc_sampler_start(const IotcSamplerConfig *config);
+
+// Stops the sampler thread. Samples already in the ring can still be polled.
+void iotc_sampler_stop(void);
+
+// Aggregates the samples taken so far. Returns true once a window is complete.
+bool iotc_sampler_poll(void);
+
+// Stats of the last completed window, or NULL if the channel is invalid or no window was completed yet.
+const IotcSamplerStats *iotc_sampler_get_stats(UINT channel);
+
+// Writes the stats of each channel of the last completed window as <name>_min, <name>_max, <name>_avg,
+// <name>_stddev and <name>_count. IoTConnect objects are only one level deep, so channel "accelerometer.x"
+// is written as {"accelerometer":{"x_min":..,"x_max":..,...}}, same as the IoTConnect Lib would write
+// "accelerometer.x_min". Returns false if the writer overflowed.
+bool iotc_sampler_write(IotcJsonWriter *w);
+
+// Number of samples dropped because the ring was full
+ULONG iotc_sampler_dropped_count(void);
+
+#endif // IOTC_ENABLE_SAMPLER
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_SAMPLER_H
@@ -0,0 +1,120 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_SCHEMA_H
+#define IOTCONNECT_SCHEMA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "iotconnect_json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Telemetry schema templates for devices that send the same set of attributes with every message.
+
+The schema is declared once as a constant table. The quoted JSON keys are composed by the preprocessor,
+and the escaped message envelope (cpId, dtg, sdk, id...) is rendered once into the schema's envelope cache
+and rendered again only when the dtg changes. Sending a message only formats the values and the time stamps
+and copies the precomputed envelope and keys.
+Child fields of object attributes (parent.child) are written as nested objects, same as the IoTConnect Lib
+would do, and must be declared next to each other:
+
+    enum { F_TEMPERATURE, F_GYRO_X, F_STATUS, F_COUNT };
+
+    IOTC_SCHEMA_DEFINE(env_schema,
+        IOTC_SCHEMA_FIELD("temperature", IOTC_SCHEMA_NUMBER),
+        IOTC_SCHEMA_CHILD_FIELD("gyroscope", "x", IOTC_SCHEMA_NUMBER),
+        IOTC_SCHEMA_FIELD("status", IOTC_SCHEMA_STRING)
+    );
+
+    IotcSchemaValue values[F_COUNT];
+    values[F_TEMPERATURE].number = 22.5;
+    values[F_GYRO_X].number = 0.01;
+    values[F_STATUS].string = "OK";
+    iotc_schema_write_message(&writer, &env_schema, values, NULL);
+
+The names are written as-is, so they must not contain characters that need JSON escaping.
+Since the envelope cache is updated when writing, a schema must not be written from multiple threads at the same time.
+*/
+
+#ifndef IOTC_SCHEMA_MESSAGE_PREFIX_SIZE
+#define IOTC_SCHEMA_MESSAGE_PREFIX_SIZE 256
+#endif
+
+#ifndef IOTC_SCHEMA_RECORD_PREFIX_SIZE
+#define IOTC_SCHEMA_RECORD_PREFIX_SIZE 128
+#endif
+
+typedef enum {
+    IOTC_SCHEMA_NUMBER = 0,
+    IOTC_SCHEMA_STRING,
+    IOTC_SCHEMA_BOOL
+} IotcSchemaFieldType;
+
+typedef struct {
+    const char *quoted_key; // "name":
+    size_t quoted_key_len;
+    IotcSchemaFieldType type;
+    const char *parent_quoted_key; // NULL if not a child of an object attribute
+    size_t parent_quoted_key_len;
+} IotcSchemaField;
+
+// Pre-rendered envelope, up to the opening quote of the time stamp value. Managed by iotconnect_schema.c.
+typedef struct {
+    char message_prefix[IOTC_SCHEMA_MESSAGE_PREFIX_SIZE]; // {"cpId":"...","dtg":"...","mt":0,"sdk":{...},"t":"
+    size_t message_prefix_len;
+    size_t dtg_offset; // the escaped dtg within the message prefix
+    size_t dtg_len;
+    char record_prefix[IOTC_SCHEMA_RECORD_PREFIX_SIZE]; // {"id":"...","tg":"","dt":"
+    size_t record_prefix_len;
+    const char *cpid; // identity strings this envelope was rendered from
+    const char *duid;
+    const char *env;
+    bool is_valid;
+} IotcSchemaEnvelope;
+
+typedef struct {
+    const IotcSchemaField *fields;
+    size_t count;
+    IotcSchemaEnvelope *envelope;
+} IotcSchema;
+
+typedef union {
+    double number;
+    const char *string; // NULL will be sent as null
+    bool boolean;
+} IotcSchemaValue;
+
+#define IOTC_SCHEMA_QUOTED_KEY_(key) "\"" key "\":"
+
+#define IOTC_SCHEMA_FIELD(name, type) \
+    { IOTC_SCHEMA_QUOTED_KEY_(name), sizeof(IOTC_SCHEMA_QUOTED_KEY_(name)) - 1, (type), NULL, 0 }
+
+#define IOTC_SCHEMA_CHILD_FIELD(parent, child, type) \
+    { IOTC_SCHEMA_QUOTED_KEY_(child), sizeof(IOTC_SCHEMA_QUOTED_KEY_(child)) - 1, (type), \
+      IOTC_SCHEMA_QUOTED_KEY_(parent), sizeof(IOTC_SCHEMA_QUOTED_KEY_(parent)) - 1 }
+
+#define IOTC_SCHEMA_DEFINE(var, ...) \
+    static const IotcSchemaField var##_fields[] = { __VA_ARGS__ }; \
+    static IotcSchemaEnvelope var##_envelope; \
+    static const IotcSchema var = { var##_fields, sizeof(var##_fields) / sizeof(var##_fields[0]), &var##_envelope }
+
+// Writes a single data point with all schema values. If iso_time is NULL, the current time will be used.
+// The iso_time is written as-is, so it must not contain characters that need JSON escaping.
+// The values array must have schema->count entries, in the same order as the schema fields.
+bool iotc_schema_write_record(IotcJsonWriter *w, const IotcSchema *schema, const IotcSchemaValue *values,
+        const char *iso_time);
+
+// Writes a complete telemetry message with a single data point.
+bool iotc_schema_write_message(IotcJsonWriter *w, const IotcSchema *schema, const IotcSchemaValue *values,
+        const char *iso_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_SCHEMA_H
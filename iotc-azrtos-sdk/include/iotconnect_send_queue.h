@@ -0,0 +1,58 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_SEND_QUEUE_H
+#define IOTCONNECT_SEND_QUEUE_H
+
+#include <stddef.h>
+#include "tx_api.h"
+#include "iotconnect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_SEND_QUEUE compile flag.
+
+Messages passed to iotconnect_sdk_send_packet_async() are copied into a bounded queue
+and published to IoTHub by a dedicated SDK thread, so that the caller never blocks on the network.
+The queue memory is statically allocated with IOTC_SEND_QUEUE_BUFFER_SIZE bytes (4k by default)
+and the thread stack with IOTC_SEND_QUEUE_STACK_SIZE. Both can be overridden with compile-time defines.
+
+There are two priority lanes, each with its own buffer. Critical messages are held in a separate buffer of
+IOTC_SEND_QUEUE_CRITICAL_BUFFER_SIZE bytes (1k by default) and are always sent before any bulk messages.
+They are not held back by the rate limiter. Bulk messages are only sent while at least
+IOTC_SEND_QUEUE_RESERVED_PACKETS packets (2 by default) remain free in the packet pool, so that a critical
+message can always get a packet even while a large backlog is being sent. While a bulk message is held back
+by the packet pool, the rate limiter or a disconnect, a newly queued critical message is sent first.
+
+The completion callbacks are invoked from the publisher thread. With the IOTC_RATE_LIMIT_DROP_OLDEST policy,
+the callbacks of messages dropped on overflow are invoked from the thread that queues the new message,
+before the call returns and without holding any SDK locks, so they may queue again.
+The functions below are used internally by the SDK. Applications should use iotconnect.h API.
+*/
+
+#ifdef IOTC_ENABLE_SEND_QUEUE
+
+// Creates the queue and starts the publisher thread. Safe to call more than once.
+UINT iotc_send_queue_init(void);
+
+// The data is copied. The properties are not copied and must remain valid until the message is sent.
+UINT iotc_send_queue_enqueue(const void *data, size_t len, const IotConnectMessageProperties *properties,
+        IotConnectSendPriority priority, IotConnectSendCallback cb, void *cb_context);
+
+// Blocks the publisher from sending until iotc_send_queue_unlock() is called.
+// Used to safely tear down the IoTHub client while the publisher may be in the middle of a send.
+void iotc_send_queue_lock(void);
+
+void iotc_send_queue_unlock(void);
+
+#endif // IOTC_ENABLE_SEND_QUEUE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_SEND_QUEUE_H
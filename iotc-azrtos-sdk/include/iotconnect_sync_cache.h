@@ -0,0 +1,83 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifndef IOTCONNECT_SYNC_CACHE_H
+#define IOTCONNECT_SYNC_CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tx_api.h"
+#ifdef IOTC_ENABLE_SYNC_CACHE_FILEX
+#include "fx_api.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+To enable this functionality set the IOTC_ENABLE_SYNC_CACHE compile flag and call iotc_sync_cache_init()
+before iotconnect_sdk_init().
+
+The IoTHub host, client ID and DTG returned by discovery and sync are cached in persistent storage,
+so that iotconnect_sdk_init() can connect to IoTHub directly after a reboot, without the two HTTPS requests.
+Discovery and sync are run when:
+- nothing is cached, or the cache was saved for a different cpid, env or duid,
+- the cache is older than max_age_s (as per the SNTP time),
+- the connect with the cached settings fails. The cache is then discarded.
+The cache is saved again once the connect with fresh settings succeeds.
+The reconnect engine (IOTC_ENABLE_RECONNECT) and iotconnect_sdk_reconnect() with resync also discard the cache.
+
+The cache is stored either:
+- in a FileX file, if IOTC_ENABLE_SYNC_CACHE_FILEX is also set and a media is provided, or
+- through the read_cb and write_cb callbacks, for a flash key/value store or similar.
+A cache of up to IOTC_SYNC_CACHE_MAX_SIZE bytes (512 by default) is kept in RAM while in use,
+plus a buffer of the same size to build the saved cache in.
+*/
+
+#ifdef IOTC_ENABLE_SYNC_CACHE
+
+// Reads the stored cache into buffer. Return an error if nothing is stored.
+typedef UINT (*IotcSyncCacheReadCallback)(void *context, void *buffer, ULONG buffer_size, ULONG *len);
+
+// Stores len bytes of data, replacing the previous cache. len is 0 when the cache is discarded.
+typedef UINT (*IotcSyncCacheWriteCallback)(void *context, const void *data, ULONG len);
+
+typedef struct {
+    ULONG max_age_s;                // 0 means IOTC_SYNC_CACHE_DEFAULT_MAX_AGE_S (7 days)
+#ifdef IOTC_ENABLE_SYNC_CACHE_FILEX
+    FX_MEDIA *media;                // Media to store the cache file on. NULL means use the callbacks.
+    CHAR *file_name;                // Defaults to IOTC_SYNC_CACHE_DEFAULT_FILE_NAME
+#endif
+    IotcSyncCacheReadCallback read_cb;
+    IotcSyncCacheWriteCallback write_cb;
+    void *cb_context;
+} IotConnectSyncCacheConfig;
+
+typedef struct {
+    const char *host;       // IoTHub host name
+    const char *client_id;  // IoTHub device ID
+    const char *dtg;
+} IotConnectSyncCacheEntry;
+
+UINT iotc_sync_cache_init(const IotConnectSyncCacheConfig *config);
+
+bool iotc_sync_cache_is_enabled(void);
+
+// Loads the cache for the device. The entry points into the cache and is valid until the next load.
+// Saving does not change it, so the IoTHub client can keep using the loaded host and client ID.
+// Returns NX_NOT_FOUND if nothing usable is cached.
+UINT iotc_sync_cache_load(const char *cpid, const char *env, const char *duid, IotConnectSyncCacheEntry *entry);
+
+UINT iotc_sync_cache_save(const char *cpid, const char *env, const char *duid, const IotConnectSyncCacheEntry *entry);
+
+void iotc_sync_cache_invalidate(void);
+
+#endif // IOTC_ENABLE_SYNC_CACHE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_SYNC_CACHE_H
@@ -19,6 +19,13 @@
 #include "iotconnect_certs.h"
 #include "azrtos_https_client.h"
 #include "iotconnect.h"
+#include "iotconnect_send_queue.h"
+#include "iotconnect_batch.h"
+#include "iotconnect_offline.h"
+#include "iotconnect_rate_limit.h"
+#include "iotconnect_command_pool.h"
+#include "iotconnect_reconnect.h"
+#include "iotconnect_sync_cache.h"
 
 #ifdef PROTOCOL_V2_PROTOTYPE
 #include "iotconnect_request.h"
@@ -27,10 +34,43 @@
 #define RESOURCE_PATH_DSICOVERY "/api/sdk/cpid/%s/lang/M_C/ver/2.0/env/%s"
 #define RESOURCE_PATH_SYNC "%ssync"
 
+// Buffer for inbound messages that span multiple chained packets, as the parser needs a contiguous string
+#ifndef IOTC_C2D_BUFFER_SIZE
+#define IOTC_C2D_BUFFER_SIZE (2048)
+#endif
+
+// The HTTPS requests run on this thread, so it needs as much stack as the thread that calls iotconnect_sdk_init()
+#ifndef IOTC_SYNC_STACK_SIZE
+#define IOTC_SYNC_STACK_SIZE (6 * 1024)
+#endif
+
+#ifndef IOTC_SYNC_THREAD_PRIORITY
+#define IOTC_SYNC_THREAD_PRIORITY (6)
+#endif
+
 static IotclDiscoveryResponse *discovery_response = NULL;
 static IotclSyncResponse *sync_response = NULL;
 static IotclSyncResult last_sync_result = IOTCL_SR_UNKNOWN_DEVICE_STATUS;
 
+// Settings of the current connection. They point into the sync response or the sync cache.
+static const char *current_host = NULL;
+static const char *current_client_id = NULL;
+// The IoTHub client keeps pointers to the host and client ID, so the sync response that they came from
+// is kept until the client is created again, even if a newer one has replaced it. NULL with the sync cache.
+static IotclSyncResponse *connection_sync_response = NULL;
+static volatile bool is_force_sync_pending = false;
+
+#ifdef IOTC_ENABLE_BACKGROUND_SYNC
+static ULONG sync_thread_stack[IOTC_SYNC_STACK_SIZE / sizeof(ULONG)];
+static TX_THREAD sync_thread;
+static TX_SEMAPHORE sync_start_sem;
+static bool is_sync_thread_created = false;
+static volatile bool is_sync_fetching = false; // the sync thread owns the fetched_* responses
+static volatile bool is_sync_fetched = false;
+static IotclDiscoveryResponse *fetched_discovery_response = NULL;
+static IotclSyncResponse *fetched_sync_response = NULL;
+#endif
+
 static IotConnectClientConfig config = { 0 };
 static IotclConfig lib_config = { 0 };
 
@@ -128,12 +168,12 @@ static IotclDiscoveryResponse* run_http_discovery(const char *cpid, const char *
     return ret;
 }
 
-static IotclSyncResponse* run_http_sync(const char *cpid, const char *uniqueid) {
+static IotclSyncResponse* run_http_sync(const IotclDiscoveryResponse *dr, const char *cpid, const char *uniqueid) {
     IotConnectHttpRequest req = { 0 };
     char post_data[IOTCONNECT_DISCOVERY_PROTOCOL_POST_DATA_MAX_LEN + 1] = {0};
-    char sync_path[strlen(discovery_response->path) + strlen("sync?") + 1];
+    char sync_path[strlen(dr->path) + strlen("sync?") + 1];
 
-    sprintf(sync_path, RESOURCE_PATH_SYNC, discovery_response->path);
+    sprintf(sync_path, RESOURCE_PATH_SYNC, dr->path);
     snprintf(post_data,
              IOTCONNECT_DISCOVERY_PROTOCOL_POST_DATA_MAX_LEN, /*total length should not exceed MTU size*/
              IOTCONNECT_DISCOVERY_PROTOCOL_POST_DATA_TEMPLATE,
@@ -142,7 +182,7 @@ static IotclSyncResponse* run_http_sync(const char *cpid, const char *uniqueid)
     );
 
     req.azrtos_config = &azrtos_config;
-    req.host_name = discovery_response->host;
+    req.host_name = dr->host;
     req.resource = sync_path;
     req.payload = post_data;
     req.tls_cert = (unsigned char*) IOTCONNECT_GODADDY_G2_ROOT_CERT;
@@ -188,35 +228,193 @@ static IotclSyncResponse* run_http_sync(const char *cpid, const char *uniqueid)
 }
 
 // this function will Give you Device CallBack payload
-static void on_iothub_data(UCHAR *data, size_t len) {
-    char *str = malloc(len + 1);
-    memcpy(str, data, len);
-    str[len] = 0;
+// Messages that fit into a single packet are parsed where they are. Messages spanning multiple chained packets
+// are assembled here, as the parser needs a contiguous string.
+// Only one thread dispatches messages: the receive thread if IOTC_ENABLE_RECEIVE_THREAD is set,
+// or else the thread calling iotconnect_sdk_poll(), so the buffer is not shared.
+static void on_iothub_data(const IotConnectC2dMessage *message) {
+    static char c2d_buffer[IOTC_C2D_BUFFER_SIZE];
+    const char *str;
+    if (message->is_null_terminated) {
+        str = (const char *) message->segments[0].data;
+    } else {
+        if (message->len >= sizeof(c2d_buffer)) {
+            printf("IOTC: Message of %u bytes exceeds IOTC_C2D_BUFFER_SIZE\r\n", (unsigned int) message->len);
+            return;
+        }
+        iothub_c2d_message_copy(message, 0, c2d_buffer, message->len);
+        c2d_buffer[message->len] = 0;
+        str = c2d_buffer;
+    }
     printf("IOTC: event>>> %s\r\n", str);
     if (!iotcl_process_event(str)) {
         printf("IOTC: Error encountered while processing %s\r\n", str);
     }
-    free(str);
 }
 
+#ifdef IOTC_ENABLE_COMMAND_POOL
+static void on_command_dispatch(IotclEventData data) {
+    iotc_command_pool_submit_command(data, config.cmd_cb);
+}
+
+static void on_ota_dispatch(IotclEventData data) {
+    iotc_command_pool_submit_ota(data, config.ota_cb);
+}
+#endif
+
 static void on_iotconnect_status(IotConnectConnectionStatus status) {
+#ifdef IOTC_ENABLE_RECONNECT
+    if (MQTT_DISCONNECTED == status
+            && iotc_reconnect_start(iothub_client_get_disconnect_reason(), on_iotconnect_status)) {
+        status = MQTT_RECONNECTING;
+    }
+#endif
     if (config.status_cb) {
         config.status_cb(status);
     }
 }
+static void disconnect_iothub(void) {
+#ifdef IOTC_ENABLE_SEND_QUEUE
+    // ensure that the publisher is not in the middle of sending
+    iotc_send_queue_lock();
+    iothub_client_disconnect();
+    iotc_send_queue_unlock();
+#else
+    iothub_client_disconnect();
+#endif
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 // Get All twin property from C2D
 void iotconnect_sdk_disconnect() {
+#ifdef IOTC_ENABLE_RECONNECT
+    iotc_reconnect_cancel();
+#endif
+#ifdef IOTC_ENABLE_TELEMETRY_BATCH
+    iotc_batch_flush();
+#endif
     printf("IOTC: Disconnecting...\r\n");
-    iothub_client_disconnect();
+    disconnect_iothub();
+}
+
+static UINT sdk_init(void);
+
+UINT iotconnect_sdk_reconnect(bool resync) {
+    if (!resync) {
+        UINT status = iothub_client_reconnect();
+        if (NX_NOT_ENABLED != status) {
+            return status;
+        }
+        // the client was released and needs to be created again
+    } else {
+        printf("IOTC: Running discovery and sync again...\r\n");
+#ifdef IOTC_ENABLE_SYNC_CACHE
+        iotc_sync_cache_invalidate();
+#endif
+    }
+    disconnect_iothub();
+    return sdk_init();
+}
+
+static UINT send_or_store(const void *data, size_t len, const IotConnectMessageProperties *properties) {
+#ifdef IOTC_ENABLE_OFFLINE_QUEUE
+    // no need to spend rate limit tokens on messages that are not transmitted now
+    if (iotc_offline_is_enabled() && !iothub_client_is_connected()) {
+        return iotc_offline_store(data, len, properties);
+    }
+#endif
+#ifdef IOTC_ENABLE_RATE_LIMIT
+    UINT status = iotc_rate_limit_admit(len);
+    if (NX_NOT_SUPPORTED == status) {
+        return status; // the policy does not apply to direct sends
+    } else if (status) {
+#ifdef IOTC_ENABLE_OFFLINE_QUEUE
+        if (IOTC_RATE_LIMIT_DEFER == iotc_rate_limit_get_policy() && iotc_offline_is_enabled()) {
+            return iotc_offline_store(data, len, properties);
+        }
+#endif
+        printf("IOTC: Rate limit exceeded. Dropping the message.\r\n");
+        return NX_NO_MORE_ENTRIES;
+    }
+#endif
+#ifdef IOTC_ENABLE_OFFLINE_QUEUE
+    if (iotc_offline_is_enabled()) {
+        if (iothub_send_message_n(data, len, properties)) {
+            printf("IOTC: Send failed. Storing the message for later.\r\n");
+            return iotc_offline_store(data, len, properties);
+        }
+        return NX_SUCCESS;
+    }
+#endif
+    return iothub_send_message_n(data, len, properties);
 }
 
 void iotconnect_sdk_send_packet(const char *data) {
-    if (iothub_send_message(data)) {
+    if (send_or_store(data, strlen(data), NULL)) {
         printf("IOTC: Failed to send message %s\r\n", data);
     }
 }
 
+UINT iotconnect_sdk_send_packet_n(const void *data, size_t len, const IotConnectMessageProperties *properties) {
+    UINT status = send_or_store(data, len, properties);
+    if (status) {
+        printf("IOTC: Failed to send a message of %u bytes. Error: 0x%x\r\n", (unsigned int) len, status);
+    }
+    return status;
+}
+
+UINT iotconnect_sdk_format_message_properties(IotConnectMessageProperties *properties, char *buffer, size_t buffer_size) {
+    size_t len;
+    UINT status;
+    if (!properties || !buffer) {
+        return NX_INVALID_PARAMETERS;
+    }
+    status = iothub_message_properties_encode(properties->items, properties->count, buffer, buffer_size, &len);
+    if (status) {
+        printf("IOTC: Message properties do not fit into the buffer\r\n");
+        return status;
+    }
+    properties->formatted = buffer;
+    properties->formatted_len = len;
+    return NX_SUCCESS;
+}
+
+UINT iotconnect_sdk_send_packet_qos(const void *data, size_t len, const IotConnectMessageProperties *properties,
+        IotConnectQos qos) {
+    if (NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS == (UINT) qos) {
+        return iotconnect_sdk_send_packet_n(data, len, properties);
+    }
+    // no logging here. These are expected to be dropped under load.
+#ifdef IOTC_ENABLE_RATE_LIMIT
+    if (!iothub_client_is_connected()) {
+        return NX_AZURE_IOT_DISCONNECTED; // do not spend (or wait for) the tokens if the send will fail anyway
+    }
+    UINT status = iotc_rate_limit_admit(len);
+    if (status) {
+        return (NX_NOT_SUPPORTED == status) ? status : NX_NO_MORE_ENTRIES;
+    }
+#endif
+    return iothub_send_message_qos(data, len, properties, (UINT) qos);
+}
+
+#ifdef IOTC_ENABLE_SEND_QUEUE
+UINT iotconnect_sdk_send_packet_async(const char *data, IotConnectSendCallback cb, void *cb_context) {
+    if (!data) {
+        return NX_INVALID_PARAMETERS;
+    }
+    return iotconnect_sdk_send_packet_async_n(data, strlen(data), NULL, IOTC_PRIORITY_BULK, cb, cb_context);
+}
+
+UINT iotconnect_sdk_send_packet_async_n(const void *data, size_t len, const IotConnectMessageProperties *properties,
+        IotConnectSendPriority priority, IotConnectSendCallback cb, void *cb_context) {
+    UINT status = iotc_send_queue_enqueue(data, len, properties, priority, cb, cb_context);
+    if (status) {
+        printf("IOTC: Failed to queue message. Error: 0x%x\r\n", status);
+    }
+    return status;
+}
+#endif
+
 #ifdef PROTOCOL_V2_PROTOTYPE
 static void on_message_intercept(IotclEventData data, IotclEventType type) {
 #else
@@ -224,21 +422,9 @@ static void on_message_intercept(IotclEventData data, IotclEventType type) {
 #endif
     switch (type) {
     case ON_FORCE_SYNC:
-	    printf("IOTC: Got ON_FORCE_SYNC. Disconnecting.\r\n");
-        iotconnect_sdk_disconnect();
-        iotcl_discovery_free_discovery_response(discovery_response);
-        iotcl_discovery_free_sync_response(sync_response);
-        sync_response = NULL;
-        discovery_response = run_http_discovery(config.cpid, config.env);
-        if (NULL == discovery_response) {
-            printf("IOTC: Unable to run HTTP discovery on ON_FORCE_SYNC \r\n");
-            return;
-        }        
-        sync_response = run_http_sync(config.cpid, config.duid);
-        if (NULL == sync_response) {
-            printf("IOTC: Unable to run HTTP sync on ON_FORCE_SYNC \r\n");
-            return;
-        }
+        // Don't block the reception with the HTTPS request. The connection is kept while syncing.
+	    printf("IOTC: Got ON_FORCE_SYNC. Sync will run on the next poll.\r\n");
+        is_force_sync_pending = true;
 		break;
     case ON_CLOSE:
         printf("IOTC: Got a disconnect request. Closing the mqtt connection. Device restart is required.\r\n");
@@ -253,12 +439,215 @@ static void on_message_intercept(IotclEventData data, IotclEventType type) {
     }
 }
 
+static UINT connect_iothub(const char *host, const char *client_id, const char *dtg);
+
+static bool is_same(const char *a, const char *b) {
+    return a && b && 0 == strcmp(a, b);
+}
+
+// Frees a sync response that was replaced, unless it is still in use
+static void release_sync_response(IotclSyncResponse *response) {
+    if (response != sync_response && response != connection_sync_response) {
+        iotcl_discovery_free_sync_response(response);
+    }
+}
+
+// Runs discovery if it did not run yet, then sync. Does not touch the state that the other threads use.
+static IotclSyncResponse *fetch_force_sync(IotclDiscoveryResponse **dr) {
+    if (NULL == *dr) {
+        // connected with the sync cache, so discovery did not run yet
+        *dr = run_http_discovery(config.cpid, config.env);
+        if (NULL == *dr) {
+            printf("IOTC: Unable to run HTTP discovery on ON_FORCE_SYNC \r\n");
+            return NULL;
+        }
+    }
+    IotclSyncResponse *response = run_http_sync(*dr, config.cpid, config.duid);
+    // do not hold on to the TLS buffers and the socket while connected
+    iotconnect_https_close();
+    if (NULL == response) {
+        printf("IOTC: Unable to run HTTP sync on ON_FORCE_SYNC \r\n");
+    }
+    return response;
+}
+
+// Applies the sync response of ON_FORCE_SYNC. Reconnects only if the IoTHub connection settings changed.
+static void apply_force_sync(IotclSyncResponse *new_sync_response) {
+    if (NULL == new_sync_response) {
+        return;
+    }
+    IotclSyncResponse *old_sync_response = sync_response;
+    IotclSyncResponse *old_connection_sync_response = connection_sync_response;
+    sync_response = new_sync_response;
+
+    if (is_same(current_host, new_sync_response->broker.host)
+            && is_same(current_client_id, new_sync_response->broker.client_id)) {
+        printf("IOTC: Sync complete. The connection settings did not change.\r\n");
+        // only the DTG is handed over. The connection keeps using the host and client ID it was created with.
+        lib_config.telemetry.dtg = new_sync_response->dtg;
+        iotcl_get_config()->telemetry.dtg = new_sync_response->dtg;
+    } else {
+        printf("IOTC: Sync complete. The connection settings changed. Reconnecting...\r\n");
+        disconnect_iothub();
+        connection_sync_response = new_sync_response;
+        if (connect_iothub(new_sync_response->broker.host, new_sync_response->broker.client_id, new_sync_response->dtg)) {
+            printf("IOTC: Failed to reconnect after ON_FORCE_SYNC\r\n");
+#ifdef IOTC_ENABLE_RECONNECT
+            iotc_reconnect_start(iothub_client_get_disconnect_reason(), on_iotconnect_status);
+#endif
+        }
+    }
+    release_sync_response(old_sync_response);
+    if (old_connection_sync_response != old_sync_response) {
+        release_sync_response(old_connection_sync_response);
+    }
+
+#ifdef IOTC_ENABLE_SYNC_CACHE
+    // If we connected with the cache, the IoTHub client still refers to the loaded host and client ID.
+    // The save does not overwrite them.
+    if (iotc_sync_cache_is_enabled()) {
+        const IotConnectSyncCacheEntry entry = {
+                new_sync_response->broker.host, new_sync_response->broker.client_id, new_sync_response->dtg
+        };
+        iotc_sync_cache_save(config.cpid, config.env, config.duid, &entry);
+    }
+#endif
+}
+
+#ifdef IOTC_ENABLE_BACKGROUND_SYNC
+static void sync_thread_entry(ULONG parameter) {
+    (void) parameter; // unused
+    while (true) {
+        tx_semaphore_get(&sync_start_sem, TX_WAIT_FOREVER);
+        fetched_sync_response = fetch_force_sync(&fetched_discovery_response);
+        is_sync_fetched = true;
+    }
+}
+
+static UINT create_sync_thread(void) {
+    UINT status;
+    if (is_sync_thread_created) {
+        return NX_SUCCESS;
+    }
+    if ((status = tx_semaphore_create(&sync_start_sem, "IOTC Sync Start", 0))) {
+        printf("IOTC: Failed to create the sync semaphore: 0x%x\r\n", status);
+        return status;
+    }
+    if ((status = tx_thread_create(&sync_thread, "IOTC Sync",
+            sync_thread_entry, 0,
+            sync_thread_stack, sizeof(sync_thread_stack),
+            IOTC_SYNC_THREAD_PRIORITY, IOTC_SYNC_THREAD_PRIORITY,
+            TX_NO_TIME_SLICE, TX_AUTO_START))) {
+        printf("IOTC: Failed to create the sync thread: 0x%x\r\n", status);
+        tx_semaphore_delete(&sync_start_sem);
+        return status;
+    }
+    is_sync_thread_created = true;
+    return NX_SUCCESS;
+}
+
+// Takes over the responses fetched by the sync thread. Must be called once is_sync_fetched is set.
+static IotclSyncResponse *take_fetched_sync(void) {
+    if (NULL == discovery_response) {
+        discovery_response = fetched_discovery_response;
+    } else if (fetched_discovery_response != discovery_response) {
+        iotcl_discovery_free_discovery_response(fetched_discovery_response);
+    }
+    fetched_discovery_response = NULL;
+    IotclSyncResponse *response = fetched_sync_response;
+    fetched_sync_response = NULL;
+    is_sync_fetched = false;
+    is_sync_fetching = false;
+    return response;
+}
+
+// The responses are about to be freed, so let a sync in progress complete and drop its result
+static void cancel_force_sync(void) {
+    if (!is_sync_fetching) {
+        return;
+    }
+    while (!is_sync_fetched) {
+        tx_thread_sleep(NX_IP_PERIODIC_RATE / 10 + 1);
+    }
+    iotcl_discovery_free_sync_response(take_fetched_sync());
+}
+#endif
+
+// The HTTPS requests of ON_FORCE_SYNC take a while, so with IOTC_ENABLE_BACKGROUND_SYNC they run on the sync thread
+// and the connection and the telemetry keep going. The result is applied here on the application thread,
+// which owns the responses and the library config.
+static void poll_force_sync(void) {
+#ifdef IOTC_ENABLE_BACKGROUND_SYNC
+    if (is_sync_fetching) {
+        if (is_sync_fetched) {
+            apply_force_sync(take_fetched_sync());
+        }
+        return; // an ON_FORCE_SYNC received in the meantime is handled next time
+    }
+    if (is_force_sync_pending && is_sync_thread_created) {
+        is_force_sync_pending = false;
+        fetched_discovery_response = discovery_response;
+        is_sync_fetching = true;
+        tx_semaphore_put(&sync_start_sem);
+    }
+#else
+    if (is_force_sync_pending) {
+        is_force_sync_pending = false;
+        apply_force_sync(fetch_force_sync(&discovery_response));
+    }
+#endif
+}
+
+// The receive loop wakes up this often to run what iotconnect_sdk_poll() would run, like a pending sync
+#ifndef IOTC_RECEIVE_LOOP_INTERVAL_MS
+#define IOTC_RECEIVE_LOOP_INTERVAL_MS (1000)
+#endif
+
+static bool is_reconnecting(void) {
+#ifdef IOTC_ENABLE_RECONNECT
+    const IotConnectReconnectState state = iotc_reconnect_get_state();
+    return IOTC_RECONNECT_IDLE != state && IOTC_RECONNECT_FAILED != state;
+#else
+    return false;
+#endif
+}
+
 void IotConnectSdk_Loop() {
-    iothub_c2d_receive(true, NX_WAIT_FOREVER);
+    // ON_FORCE_SYNC and the reconnect attempts are serviced by the poll, so do not block in the receive
+    do {
+        iotconnect_sdk_poll(IOTC_RECEIVE_LOOP_INTERVAL_MS);
+    } while (iothub_client_is_connected() || is_reconnecting());
+}
+
+void iotconnect_sdk_receive() {
+    IotConnectSdk_Loop();
 }
 
 void iotconnect_sdk_poll(UINT wait_time_ms) {
+#ifdef IOTC_ENABLE_RECONNECT
+    bool resync;
+    if (iotc_reconnect_take_pending_attempt(&resync)) {
+        iotc_reconnect_attempt_done(iotconnect_sdk_reconnect(resync));
+    }
+#endif
+    poll_force_sync();
+#ifdef IOTC_ENABLE_TELEMETRY_BATCH
+    iotc_batch_poll();
+#endif
+#ifdef IOTC_ENABLE_OFFLINE_QUEUE
+    iotc_offline_drain();
+#endif
+#ifdef IOTC_ENABLE_RECEIVE_THREAD
+    // messages are dispatched by the receive thread as they arrive
+    tx_thread_sleep(wait_time_ms * NX_IP_PERIODIC_RATE / 1000);
+#else
+    if (!iothub_client_is_connected()) {
+        // the client may have been released. Keep the pace while the SDK is reconnecting.
+        tx_thread_sleep(wait_time_ms * NX_IP_PERIODIC_RATE / 1000);
+        return;
+    }
     iothub_c2d_receive(false, wait_time_ms * NX_IP_PERIODIC_RATE / 1000);
+#endif
 }
 
 IotclConfig* iotconnect_sdk_get_lib_config() {
@@ -296,21 +685,108 @@ IotclSyncResult iotconnect_get_last_sync_result() {
 	return last_sync_result;
 }
 
-///////////////////////////////////////////////////////////////////////////////////
-// this the Initialization os IoTConnect SDK
-UINT iotconnect_sdk_init(IotConnectAzrtosConfig *ac) {
-	UINT ret;
-	IotConnectIotHubConfig iic;
+// Initializes the library and connects to IoTHub. The strings must remain valid while connected.
+static UINT connect_iothub(const char *host, const char *client_id, const char *dtg) {
+    UINT ret;
+    IotConnectIotHubConfig iic;
 
-	memcpy(&azrtos_config, ac, sizeof(azrtos_config));
     memset(&iic, 0, sizeof(iic));
+    iic.c2d_msg_cb = on_iothub_data;
+
+    iic.device_name = (char *) client_id;
+    iic.host = (char *) host;
+    current_host = host;
+    current_client_id = client_id;
+    iic.auth = &config.auth;
+    iic.status_cb = on_iotconnect_status;
+
+    lib_config.device.env = config.env;
+    lib_config.device.cpid = config.cpid;
+    lib_config.device.duid = config.duid;
+
+    lib_config.event_functions.ota_cb = config.ota_cb;
+    lib_config.event_functions.cmd_cb = config.cmd_cb;
+#ifdef IOTC_ENABLE_COMMAND_POOL
+    // run the callbacks on the worker threads, so that the reception can continue
+    if (iotc_command_pool_is_enabled()) {
+        lib_config.event_functions.ota_cb = config.ota_cb ? on_ota_dispatch : NULL;
+        lib_config.event_functions.cmd_cb = config.cmd_cb ? on_command_dispatch : NULL;
+    }
+#endif
+
+    // intercept internal processing and forward to client
+    lib_config.event_functions.msg_cb = on_message_intercept;
+
+    lib_config.telemetry.dtg = (char *) dtg;
+
+    if (!iotcl_init(&lib_config)) {
+        printf("IOTC: Failed to initialize the IoTConnect Lib\r\n");
+        return NX_FALSE;
+    }
+
+#ifdef IOTC_ENABLE_SEND_QUEUE
+    ret = iotc_send_queue_init();
+    if (ret) {
+        printf("IOTC: Failed to initialize the send queue!\r\n");
+        return ret;
+    }
+#endif
+
+    // the HTTPS connection kept for discovery and sync is not needed any more
+    iotconnect_https_close();
+
+    printf("IOTC: Connecting to IoTHub.\r\n");
+    ret = iothub_client_init(&iic, &azrtos_config);
+    if (ret) {
+        printf("IOTC: Failed to connect!\r\n");
+    	return ret;
+    }
+
+    return ret;
+}
+
+// Runs discovery and sync, unless the sync cache can be used, then connects with the stored azrtos_config
+static UINT sdk_init(void) {
+	UINT ret;
 
     last_sync_result = IOTCL_SR_UNKNOWN_DEVICE_STATUS;
 
+#ifdef IOTC_ENABLE_BACKGROUND_SYNC
+    cancel_force_sync();
+    ret = create_sync_thread();
+    if (ret) {
+        return ret;
+    }
+#endif
+	is_force_sync_pending = false;
+	// the IoTHub client is not initialized at this point, so it does not refer to either response
+	if (connection_sync_response != sync_response) {
+		iotcl_discovery_free_sync_response(connection_sync_response);
+	}
+	connection_sync_response = NULL;
 	iotcl_discovery_free_discovery_response(discovery_response);
 	iotcl_discovery_free_sync_response(sync_response);
 	discovery_response = NULL;
 	sync_response = NULL;
+	current_host = NULL;
+	current_client_id = NULL;
+
+#ifdef IOTC_ENABLE_SYNC_CACHE
+    // skip the discovery and sync HTTPS requests if we can connect with what we got last time
+    IotConnectSyncCacheEntry cached;
+    if (iotc_sync_cache_is_enabled()
+            && NX_SUCCESS == iotc_sync_cache_load(config.cpid, config.env, config.duid, &cached)) {
+        printf("IOTC: Using the cached sync response.\r\n");
+        last_sync_result = IOTCL_SR_OK;
+        if (NX_SUCCESS == connect_iothub(cached.host, cached.client_id, cached.dtg)) {
+            return NX_SUCCESS;
+        }
+        printf("IOTC: Unable to connect with the cached sync response.\r\n");
+        iotc_sync_cache_invalidate();
+        last_sync_result = IOTCL_SR_UNKNOWN_DEVICE_STATUS;
+    }
+#endif
+
     printf("IOTC: Performing discovery...\r\n");
     discovery_response = run_http_discovery(config.cpid, config.env);
     if (NULL == discovery_response) {
@@ -319,7 +795,7 @@ UINT iotconnect_sdk_init(IotConnectAzrtosConfig *ac) {
     }
     printf("IOTC: Discovery response parsing successful. Performing sync...\r\n");
     
-    sync_response = run_http_sync(config.cpid, config.duid);
+    sync_response = run_http_sync(discovery_response, config.cpid, config.duid);
     if (NULL == sync_response) {
         // Sync_call will print the error
         return -2;
@@ -333,39 +809,22 @@ UINT iotconnect_sdk_init(IotConnectAzrtosConfig *ac) {
     printf("IOTC: CPID: %s***\r\n", cpid_buff);
     printf("IOTC: ENV:  %s\r\n", config.env);
 
-    iic.c2d_msg_cb = on_iothub_data;
-
-    iic.device_name = sync_response->broker.client_id;
-    iic.host = sync_response->broker.host;
-    iic.auth = &config.auth;
-    iic.status_cb = on_iotconnect_status;
-
-    lib_config.device.env = config.env;
-    lib_config.device.cpid = config.cpid;
-    lib_config.device.duid = config.duid;
-
-    lib_config.event_functions.ota_cb = config.ota_cb;
-    lib_config.event_functions.cmd_cb = config.cmd_cb;
-    lib_config.event_functions.msg_cb = on_message_intercept;
-
-
-    // intercept internal processing and forward to client
-    lib_config.event_functions.msg_cb = on_message_intercept;
-
-    lib_config.telemetry.dtg = sync_response->dtg;
-
-    if (!iotcl_init(&lib_config)) {
-        printf("IOTC: Failed to initialize the IoTConnect Lib\r\n");
-        return NX_FALSE;
-    }
-
-    printf("IOTC: Connecting to IoTHub.\r\n");
-    ret = iothub_client_init(&iic, &azrtos_config);
-    if (ret) {
-        printf("IOTC: Failed to connect!\r\n");
-    	return ret;
+    connection_sync_response = sync_response;
+    ret = connect_iothub(sync_response->broker.host, sync_response->broker.client_id, sync_response->dtg);
+#ifdef IOTC_ENABLE_SYNC_CACHE
+    if (NX_SUCCESS == ret && iotc_sync_cache_is_enabled()) {
+        const IotConnectSyncCacheEntry entry = {
+                sync_response->broker.host, sync_response->broker.client_id, sync_response->dtg
+        };
+        iotc_sync_cache_save(config.cpid, config.env, config.duid, &entry);
     }
-
+#endif
     return ret;
+}
 
+///////////////////////////////////////////////////////////////////////////////////
+// this the Initialization os IoTConnect SDK
+UINT iotconnect_sdk_init(IotConnectAzrtosConfig *ac) {
+	memcpy(&azrtos_config, ac, sizeof(azrtos_config));
+	return sdk_init();
 }
@@ -0,0 +1,229 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_TELEMETRY_BATCH
+
+#include <string.h>
+#include <stdio.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "azrtos_iothub_client.h"
+#include "iotconnect_json_writer.h"
+#include "iotconnect_send_queue.h"
+#include "iotconnect_batch.h"
+
+#ifndef IOTC_BATCH_BUFFER_SIZE
+#define IOTC_BATCH_BUFFER_SIZE (2 * 1024)
+#endif
+
+#ifndef IOTC_BATCH_RECORD_BUFFER_SIZE
+#define IOTC_BATCH_RECORD_BUFFER_SIZE 256
+#endif
+
+#define BATCH_FOOTER "]}"
+
+static char batch_buffer[IOTC_BATCH_BUFFER_SIZE];
+static size_t batch_len = 0;
+static UINT batch_count = 0;
+static ULONG batch_start_ticks = 0;
+
+static char record_buffer[IOTC_BATCH_RECORD_BUFFER_SIZE];
+static IotcJsonWriter record_writer;
+static bool record_active = false;
+
+static IotConnectBatchConfig config = { 0 };
+static TX_MUTEX batch_mutex;
+static bool is_initialized = false;
+
+static UINT send_batch(void) {
+    UINT status;
+#ifdef IOTC_ENABLE_SEND_QUEUE
+    status = iotc_send_queue_enqueue(batch_buffer, batch_len, NULL, IOTC_PRIORITY_BULK, NULL, NULL);
+#else
+    // goes to the offline queue, if enabled, while we are disconnected
+    status = iotconnect_sdk_send_packet_n(batch_buffer, batch_len, NULL);
+#endif
+    if (status) {
+        printf("IOTC: Failed to send a batch of %u records. Error: 0x%x\r\n", batch_count, status);
+    }
+    return status;
+}
+
+static size_t get_max_bytes(void) {
+    if (0 == config.max_bytes || config.max_bytes > sizeof(batch_buffer)) {
+        return sizeof(batch_buffer);
+    }
+    return config.max_bytes;
+}
+
+// Must be called with the mutex held
+static UINT flush_locked(void) {
+    if (0 == batch_count) {
+        return NX_SUCCESS;
+    }
+    // space for the footer is reserved when adding records
+    memcpy(&batch_buffer[batch_len], BATCH_FOOTER, sizeof(BATCH_FOOTER) - 1);
+    batch_len += sizeof(BATCH_FOOTER) - 1;
+    UINT status = send_batch();
+    batch_len = 0;
+    batch_count = 0;
+    return status;
+}
+
+static bool write_batch_header(void) {
+    IotcJsonWriter header_writer;
+    iotc_json_init_buffer(&header_writer, batch_buffer, get_max_bytes());
+    if (!iotc_json_telemetry_begin(&header_writer)) {
+        printf("IOTC: Batch: Message header does not fit into the batch buffer\r\n");
+        return false;
+    }
+    batch_len = header_writer.len;
+    batch_start_ticks = tx_time_get();
+    return true;
+}
+
+UINT iotc_batch_init(const IotConnectBatchConfig *c) {
+    UINT status;
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (!is_initialized) {
+        if ((status = tx_mutex_create(&batch_mutex, "IOTC Batch", TX_INHERIT))) {
+            printf("IOTC: Failed to create the batch mutex: 0x%x\r\n", status);
+            return status;
+        }
+        is_initialized = true;
+    }
+    tx_mutex_get(&batch_mutex, TX_WAIT_FOREVER);
+    status = flush_locked();
+    memcpy(&config, c, sizeof(config));
+    tx_mutex_put(&batch_mutex);
+    return status;
+}
+
+bool iotc_batch_record_begin(const char *iso_time) {
+    if (!is_initialized) {
+        printf("IOTC: Batch: Not initialized\r\n");
+        return false;
+    }
+    // The record is composed without holding the mutex. It is only taken in iotc_batch_record_end()
+    // when the record is appended to the batch, so an abandoned record cannot block poll or flush.
+    // Any record that was begun but never ended is discarded here.
+    record_active = false;
+    iotc_json_init_buffer(&record_writer, record_buffer, sizeof(record_buffer));
+    if (!iotc_json_telemetry_record_begin(&record_writer, iso_time)) {
+        printf("IOTC: Batch: Record header does not fit into IOTC_BATCH_RECORD_BUFFER_SIZE\r\n");
+        return false;
+    }
+    record_active = true;
+    return true;
+}
+
+void iotc_batch_record_abort(void) {
+    record_active = false;
+}
+
+bool iotc_batch_set_number(const char *name, double value) {
+    if (!record_active) {
+        return false; // record_begin not called?
+    }
+    return iotc_json_set_number(&record_writer, name, value);
+}
+
+bool iotc_batch_set_string(const char *name, const char *value) {
+    if (!record_active) {
+        return false;
+    }
+    return iotc_json_set_string(&record_writer, name, value);
+}
+
+bool iotc_batch_set_bool(const char *name, bool value) {
+    if (!record_active) {
+        return false;
+    }
+    return iotc_json_set_bool(&record_writer, name, value);
+}
+
+bool iotc_batch_set_null(const char *name) {
+    if (!record_active) {
+        return false;
+    }
+    return iotc_json_set_null(&record_writer, name);
+}
+
+UINT iotc_batch_record_end(void) {
+    UINT status = NX_SUCCESS;
+    UINT flush_status = NX_SUCCESS;
+    if (!record_active) {
+        return NX_INVALID_PARAMETERS; // record_begin not called or failed
+    }
+    record_active = false;
+    if (!iotc_json_telemetry_record_end(&record_writer)) {
+        printf("IOTC: Batch: Record does not fit into IOTC_BATCH_RECORD_BUFFER_SIZE. Discarding.\r\n");
+        return NX_SIZE_ERROR;
+    }
+    const size_t record_len = record_writer.len;
+
+    tx_mutex_get(&batch_mutex, TX_WAIT_FOREVER);
+    const size_t max_bytes = get_max_bytes();
+    // comma + record + footer + null
+    if (batch_count > 0 && batch_len + 1 + record_len + sizeof(BATCH_FOOTER) > max_bytes) {
+        // the record is still added to a new batch below, but the failed flush must be reported
+        flush_status = flush_locked();
+    }
+    if (0 == batch_count) {
+        if (!write_batch_header()) {
+            status = NX_SIZE_ERROR;
+            goto end;
+        }
+        if (batch_len + record_len + sizeof(BATCH_FOOTER) > max_bytes) {
+            printf("IOTC: Batch: Record does not fit into the batch byte budget. Discarding.\r\n");
+            batch_len = 0;
+            status = NX_SIZE_ERROR;
+            goto end;
+        }
+    } else {
+        batch_buffer[batch_len++] = ',';
+    }
+    memcpy(&batch_buffer[batch_len], record_buffer, record_len);
+    batch_len += record_len;
+    batch_count++;
+
+    if (config.max_records > 0 && batch_count >= config.max_records) {
+        status = flush_locked();
+    } else if (config.max_latency_ms > 0
+            && tx_time_get() - batch_start_ticks >= (ULONG) config.max_latency_ms * TX_TIMER_TICKS_PER_SECOND / 1000) {
+        status = flush_locked();
+    }
+
+end:
+    tx_mutex_put(&batch_mutex);
+    return flush_status ? flush_status : status;
+}
+
+UINT iotc_batch_flush(void) {
+    if (!is_initialized) {
+        return NX_SUCCESS;
+    }
+    tx_mutex_get(&batch_mutex, TX_WAIT_FOREVER);
+    UINT status = flush_locked();
+    tx_mutex_put(&batch_mutex);
+    return status;
+}
+
+UINT iotc_batch_poll(void) {
+    UINT status = NX_SUCCESS;
+    if (!is_initialized || 0 == config.max_latency_ms) {
+        return NX_SUCCESS;
+    }
+    tx_mutex_get(&batch_mutex, TX_WAIT_FOREVER);
+    if (batch_count > 0
+            && tx_time_get() - batch_start_ticks >= (ULONG) config.max_latency_ms * TX_TIMER_TICKS_PER_SECOND / 1000) {
+        status = flush_locked();
+    }
+    tx_mutex_put(&batch_mutex);
+    return status;
+}
+
+#endif // IOTC_ENABLE_TELEMETRY_BATCH
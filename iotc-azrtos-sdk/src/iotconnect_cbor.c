@@ -0,0 +1,267 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_CBOR
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "iotconnect_lib.h"
+#include "iotconnect_lib_config.h"
+#include "azrtos_time.h"
+#include "iotconnect_cbor.h"
+
+// CBOR major types
+#define CBOR_UINT       (0 << 5)
+#define CBOR_NEGINT     (1 << 5)
+#define CBOR_TEXT       (3 << 5)
+#define CBOR_ARRAY      (4 << 5)
+#define CBOR_MAP        (5 << 5)
+#define CBOR_SIMPLE     (7 << 5)
+
+#define CBOR_INDEFINITE 31
+#define CBOR_FALSE      (CBOR_SIMPLE | 20)
+#define CBOR_TRUE       (CBOR_SIMPLE | 21)
+#define CBOR_NULL       (CBOR_SIMPLE | 22)
+#define CBOR_FLOAT32    (CBOR_SIMPLE | 26)
+#define CBOR_FLOAT64    (CBOR_SIMPLE | 27)
+#define CBOR_BREAK      0xff
+
+static const IotConnectMessageProperty cbor_content_type[] = {
+        { IOTC_PROPERTY_CONTENT_TYPE, "application/cbor" }
+};
+
+#define CBOR_FORMATTED_PROPERTIES IOTC_PROPERTY_CONTENT_TYPE "=application%2Fcbor"
+
+const IotConnectMessageProperties iotc_cbor_message_properties = {
+        .items = cbor_content_type,
+        .count = sizeof(cbor_content_type) / sizeof(cbor_content_type[0]),
+        .formatted = CBOR_FORMATTED_PROPERTIES,
+        .formatted_len = sizeof(CBOR_FORMATTED_PROPERTIES) - 1
+};
+
+static void cbor_put(IotcCborWriter *w, const void *data, size_t len) {
+    if (w->overflow || w->len + len > w->size) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buffer[w->len], data, len);
+    w->len += len;
+}
+
+static void cbor_put_byte(IotcCborWriter *w, UCHAR b) {
+    cbor_put(w, &b, 1);
+}
+
+static void cbor_put_head(IotcCborWriter *w, UCHAR major_type, unsigned long long value) {
+    UCHAR head[9];
+    size_t num_bytes;
+    if (value < 24) {
+        cbor_put_byte(w, (UCHAR) (major_type | value));
+        return;
+    } else if (value <= 0xff) {
+        head[0] = major_type | 24;
+        num_bytes = 1;
+    } else if (value <= 0xffff) {
+        head[0] = major_type | 25;
+        num_bytes = 2;
+    } else if (value <= 0xffffffffULL) {
+        head[0] = major_type | 26;
+        num_bytes = 4;
+    } else {
+        head[0] = major_type | 27;
+        num_bytes = 8;
+    }
+    // big endian
+    for (size_t i = num_bytes; i > 0; i--) {
+        head[i] = (UCHAR) (value & 0xff);
+        value >>= 8;
+    }
+    cbor_put(w, head, num_bytes + 1);
+}
+
+void iotc_cbor_init(IotcCborWriter *w, void *buffer, size_t size) {
+    w->buffer = (UCHAR *) buffer;
+    w->size = size;
+    w->len = 0;
+    w->overflow = false;
+}
+
+void iotc_cbor_map_begin(IotcCborWriter *w) {
+    cbor_put_byte(w, CBOR_MAP | CBOR_INDEFINITE);
+}
+
+void iotc_cbor_array_begin(IotcCborWriter *w) {
+    cbor_put_byte(w, CBOR_ARRAY | CBOR_INDEFINITE);
+}
+
+void iotc_cbor_end(IotcCborWriter *w) {
+    cbor_put_byte(w, CBOR_BREAK);
+}
+
+void iotc_cbor_text(IotcCborWriter *w, const char *str) {
+    const size_t len = strlen(str);
+    cbor_put_head(w, CBOR_TEXT, len);
+    cbor_put(w, str, len);
+}
+
+void iotc_cbor_int(IotcCborWriter *w, long long value) {
+    if (value >= 0) {
+        cbor_put_head(w, CBOR_UINT, (unsigned long long) value);
+    } else {
+        // -1 - n, written this way to avoid overflow for LLONG_MIN
+        cbor_put_head(w, CBOR_NEGINT, (unsigned long long) (-1 - value));
+    }
+}
+
+void iotc_cbor_number(IotcCborWriter *w, double value) {
+    UCHAR buff[9];
+    if (isnan(value) || isinf(value)) {
+        cbor_put_byte(w, CBOR_NULL); // same as cJSON would do
+        return;
+    }
+    if (fabs(value) < 1.0e15 && value == (double) (long long) value) {
+        iotc_cbor_int(w, (long long) value);
+        return;
+    }
+    const float f = (float) value;
+    if ((double) f == value) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        buff[0] = CBOR_FLOAT32;
+        for (int i = 4; i > 0; i--) {
+            buff[i] = (UCHAR) (bits & 0xff);
+            bits >>= 8;
+        }
+        cbor_put(w, buff, 5);
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        buff[0] = CBOR_FLOAT64;
+        for (int i = 8; i > 0; i--) {
+            buff[i] = (UCHAR) (bits & 0xff);
+            bits >>= 8;
+        }
+        cbor_put(w, buff, 9);
+    }
+}
+
+void iotc_cbor_bool(IotcCborWriter *w, bool value) {
+    cbor_put_byte(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void iotc_cbor_null(IotcCborWriter *w) {
+    cbor_put_byte(w, CBOR_NULL);
+}
+
+static void cbor_put_text_pair(IotcCborWriter *w, const char *name, const char *value) {
+    iotc_cbor_text(w, name);
+    iotc_cbor_text(w, value);
+}
+
+bool iotc_cbor_telemetry_create(IotcCborTelemetry *t, void *buffer, size_t size) {
+    char now[UNIX_TIME_ISO_BUFFER_SIZE];
+    IotclConfig *lc = iotcl_get_config();
+    if (!lc) {
+        printf("IOTC: CBOR: The IoTConnect Lib is not initialized\r\n");
+        return false;
+    }
+    IotcCborWriter *w = &t->w;
+    iotc_cbor_init(w, buffer, size);
+    t->in_record = false;
+
+    iotc_cbor_map_begin(w);
+    cbor_put_text_pair(w, "cpId", lc->device.cpid);
+    cbor_put_text_pair(w, "dtg", lc->telemetry.dtg);
+    cbor_put_text_pair(w, "t", unix_time_iso_now(now, sizeof(now)));
+    iotc_cbor_text(w, "mt");
+    iotc_cbor_int(w, 0);
+    iotc_cbor_text(w, "sdk");
+    iotc_cbor_map_begin(w);
+    cbor_put_text_pair(w, "l", CONFIG_IOTCONNECT_SDK_NAME);
+    cbor_put_text_pair(w, "v", CONFIG_IOTCONNECT_SDK_VERSION);
+    cbor_put_text_pair(w, "e", lc->device.env);
+    iotc_cbor_end(w);
+    iotc_cbor_text(w, "d");
+    iotc_cbor_array_begin(w);
+    return !w->overflow;
+}
+
+bool iotc_cbor_telemetry_add_with_iso_time(IotcCborTelemetry *t, const char *iso_time) {
+    char now[UNIX_TIME_ISO_BUFFER_SIZE];
+    IotclConfig *lc = iotcl_get_config();
+    if (!lc) {
+        return false;
+    }
+    IotcCborWriter *w = &t->w;
+    if (t->in_record) {
+        iotc_cbor_end(w); // "d" map
+        iotc_cbor_end(w); // record
+    }
+    iotc_cbor_map_begin(w);
+    cbor_put_text_pair(w, "id", lc->device.duid);
+    cbor_put_text_pair(w, "tg", "");
+    cbor_put_text_pair(w, "dt", iso_time ? iso_time : unix_time_iso_now(now, sizeof(now)));
+    iotc_cbor_text(w, "d");
+    iotc_cbor_map_begin(w);
+    t->in_record = true;
+    return !w->overflow;
+}
+
+bool iotc_cbor_telemetry_set_number(IotcCborTelemetry *t, const char *name, double value) {
+    if (!t->in_record || !name) {
+        return false;
+    }
+    iotc_cbor_text(&t->w, name);
+    iotc_cbor_number(&t->w, value);
+    return !t->w.overflow;
+}
+
+bool iotc_cbor_telemetry_set_string(IotcCborTelemetry *t, const char *name, const char *value) {
+    if (!value) {
+        return iotc_cbor_telemetry_set_null(t, name);
+    }
+    if (!t->in_record || !name) {
+        return false;
+    }
+    cbor_put_text_pair(&t->w, name, value);
+    return !t->w.overflow;
+}
+
+bool iotc_cbor_telemetry_set_bool(IotcCborTelemetry *t, const char *name, bool value) {
+    if (!t->in_record || !name) {
+        return false;
+    }
+    iotc_cbor_text(&t->w, name);
+    iotc_cbor_bool(&t->w, value);
+    return !t->w.overflow;
+}
+
+bool iotc_cbor_telemetry_set_null(IotcCborTelemetry *t, const char *name) {
+    if (!t->in_record || !name) {
+        return false;
+    }
+    iotc_cbor_text(&t->w, name);
+    iotc_cbor_null(&t->w);
+    return !t->w.overflow;
+}
+
+size_t iotc_cbor_telemetry_finish(IotcCborTelemetry *t) {
+    IotcCborWriter *w = &t->w;
+    if (t->in_record) {
+        iotc_cbor_end(w); // "d" map
+        iotc_cbor_end(w); // record
+        t->in_record = false;
+    }
+    iotc_cbor_end(w); // "d" array
+    iotc_cbor_end(w); // message
+    if (w->overflow) {
+        printf("IOTC: CBOR: The message does not fit into the buffer\r\n");
+        return 0;
+    }
+    return w->len;
+}
+
+#endif // IOTC_ENABLE_CBOR
@@ -0,0 +1,223 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_COMMAND_POOL
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "iotconnect_lib.h"
+#include "iotconnect_command_pool.h"
+
+#ifndef IOTC_COMMAND_POOL_WORKERS
+#define IOTC_COMMAND_POOL_WORKERS (2)
+#endif
+
+#ifndef IOTC_COMMAND_POOL_QUEUE_SIZE
+#define IOTC_COMMAND_POOL_QUEUE_SIZE (8)
+#endif
+
+// OTA downloads run on the workers, so they need as much stack as the thread that would otherwise run them.
+// This is the smallest helper thread stack of the samples. Targets that give it more need to raise this as well.
+#ifndef IOTC_COMMAND_POOL_STACK_SIZE
+#define IOTC_COMMAND_POOL_STACK_SIZE (6 * 1024)
+#endif
+
+#ifndef IOTC_COMMAND_POOL_THREAD_PRIORITY
+#define IOTC_COMMAND_POOL_THREAD_PRIORITY (6)
+#endif
+
+// Longest command name used for the concurrency limits. Longer names are truncated.
+#define MAX_COMMAND_NAME_LEN (23)
+
+typedef void (*EventCallback)(IotclEventData data);
+
+typedef struct {
+    IotclEventData data;
+    EventCallback cb;
+    char name[MAX_COMMAND_NAME_LEN + 1];
+} WorkItem;
+
+typedef struct {
+    TX_THREAD thread;
+    ULONG stack[IOTC_COMMAND_POOL_STACK_SIZE / sizeof(ULONG)];
+    bool is_busy;
+    char name[MAX_COMMAND_NAME_LEN + 1]; // of the running command
+} Worker;
+
+static Worker workers[IOTC_COMMAND_POOL_WORKERS];
+static WorkItem queue[IOTC_COMMAND_POOL_QUEUE_SIZE]; // oldest first
+static UINT queue_count = 0;
+static TX_MUTEX pool_mutex;
+static TX_SEMAPHORE work_sem;
+static IotConnectCommandPoolConfig config = { 0 };
+static bool is_initialized = false;
+
+static UINT get_limit(const char *name) {
+    for (size_t i = 0; i < config.limit_count; i++) {
+        if (0 == strncmp(config.limits[i].command, name, MAX_COMMAND_NAME_LEN)) {
+            return config.limits[i].max_concurrent;
+        }
+    }
+    return config.default_max_concurrent;
+}
+
+// Must be called with the mutex held
+static bool is_at_limit_locked(const char *name) {
+    const UINT limit = get_limit(name);
+    UINT running = 0;
+    if (0 == limit) {
+        return false;
+    }
+    for (int i = 0; i < IOTC_COMMAND_POOL_WORKERS; i++) {
+        if (workers[i].is_busy && 0 == strcmp(workers[i].name, name)) {
+            running++;
+        }
+    }
+    return running >= limit;
+}
+
+// Takes the oldest item that is not held back by its limit. Must be called with the mutex held.
+static bool take_runnable_locked(WorkItem *item) {
+    for (UINT i = 0; i < queue_count; i++) {
+        if (!is_at_limit_locked(queue[i].name)) {
+            memcpy(item, &queue[i], sizeof(WorkItem));
+            memmove(&queue[i], &queue[i + 1], (queue_count - i - 1) * sizeof(WorkItem));
+            queue_count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void worker_thread_entry(ULONG parameter) {
+    Worker *self = &workers[parameter];
+    WorkItem item;
+    while (true) {
+        tx_semaphore_get(&work_sem, TX_WAIT_FOREVER);
+        tx_mutex_get(&pool_mutex, TX_WAIT_FOREVER);
+        if (!take_runnable_locked(&item)) {
+            // everything that is queued is at its limit. A finishing command will wake us up.
+            tx_mutex_put(&pool_mutex);
+            continue;
+        }
+        self->is_busy = true;
+        strcpy(self->name, item.name);
+        tx_mutex_put(&pool_mutex);
+
+        item.cb(item.data); // the callback owns the event data and sends the ack
+
+        tx_mutex_get(&pool_mutex, TX_WAIT_FOREVER);
+        self->is_busy = false;
+        const bool has_more = queue_count > 0;
+        tx_mutex_put(&pool_mutex);
+        if (has_more) {
+            tx_semaphore_put(&work_sem); // a command held back by the limit may be able to run now
+        }
+    }
+}
+
+static void send_failure_ack(IotclEventData data, const char *message) {
+    const char *ack = iotcl_create_ack_string_and_destroy_event(data, false, message);
+    if (ack) {
+        iotconnect_sdk_send_packet(ack);
+        free((void *) ack);
+    }
+}
+
+static UINT submit(IotclEventData data, EventCallback cb, const char *name, size_t name_len) {
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
+    if (!data || !cb) {
+        return NX_INVALID_PARAMETERS;
+    }
+    tx_mutex_get(&pool_mutex, TX_WAIT_FOREVER);
+    if (queue_count >= IOTC_COMMAND_POOL_QUEUE_SIZE) {
+        tx_mutex_put(&pool_mutex);
+        printf("IOTC: Command queue is full. Rejecting the command.\r\n");
+        send_failure_ack(data, "Device is busy");
+        return NX_OVERFLOW;
+    }
+    WorkItem *item = &queue[queue_count++];
+    item->data = data;
+    item->cb = cb;
+    if (name_len > MAX_COMMAND_NAME_LEN) {
+        name_len = MAX_COMMAND_NAME_LEN;
+    }
+    memcpy(item->name, name, name_len);
+    item->name[name_len] = 0;
+    tx_mutex_put(&pool_mutex);
+    tx_semaphore_put(&work_sem);
+    return NX_SUCCESS;
+}
+
+UINT iotc_command_pool_init(const IotConnectCommandPoolConfig *c) {
+    UINT status;
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (is_initialized) {
+        tx_mutex_get(&pool_mutex, TX_WAIT_FOREVER);
+        memcpy(&config, c, sizeof(config));
+        tx_mutex_put(&pool_mutex);
+        return NX_SUCCESS;
+    }
+    memcpy(&config, c, sizeof(config));
+    if ((status = tx_mutex_create(&pool_mutex, "IOTC Command Pool", TX_INHERIT))) {
+        printf("IOTC: Failed to create the command pool mutex: 0x%x\r\n", status);
+        return status;
+    }
+    if ((status = tx_semaphore_create(&work_sem, "IOTC Command Pool", 0))) {
+        printf("IOTC: Failed to create the command pool semaphore: 0x%x\r\n", status);
+        tx_mutex_delete(&pool_mutex);
+        return status;
+    }
+    for (ULONG i = 0; i < IOTC_COMMAND_POOL_WORKERS; i++) {
+        if ((status = tx_thread_create(&workers[i].thread, "IOTC Command Worker",
+                worker_thread_entry, i,
+                workers[i].stack, sizeof(workers[i].stack),
+                IOTC_COMMAND_POOL_THREAD_PRIORITY, IOTC_COMMAND_POOL_THREAD_PRIORITY,
+                TX_NO_TIME_SLICE, TX_AUTO_START))) {
+            printf("IOTC: Failed to create a command worker thread: 0x%x\r\n", status);
+            // the workers that were created keep running. Anything submitted will be processed by them.
+            if (0 == i) {
+                tx_semaphore_delete(&work_sem);
+                tx_mutex_delete(&pool_mutex);
+                return status;
+            }
+            break;
+        }
+    }
+    is_initialized = true;
+    return NX_SUCCESS;
+}
+
+bool iotc_command_pool_is_enabled(void) {
+    return is_initialized;
+}
+
+UINT iotc_command_pool_submit_command(IotclEventData data, IotclCommandCallback cb) {
+    UINT status;
+    const char *command = iotcl_clone_command(data);
+    if (!command) {
+        if (data) {
+            send_failure_ack(data, "Internal error");
+        }
+        return NX_INVALID_PARAMETERS;
+    }
+    const char *space = strchr(command, ' ');
+    const size_t name_len = space ? (size_t) (space - command) : strlen(command);
+    status = submit(data, cb, command, name_len);
+    free((void *) command);
+    return status;
+}
+
+UINT iotc_command_pool_submit_ota(IotclEventData data, IotclOtaCallback cb) {
+    return submit(data, cb, IOTC_COMMAND_POOL_OTA, strlen(IOTC_COMMAND_POOL_OTA));
+}
+
+#endif // IOTC_ENABLE_COMMAND_POOL
@@ -0,0 +1,327 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_COMPRESSION
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "iotconnect_compress.h"
+
+#ifndef IOTC_COMPRESS_DEFAULT_MIN_SIZE
+#define IOTC_COMPRESS_DEFAULT_MIN_SIZE (512)
+#endif
+
+// More bits find more matches at the cost of (1 << bits) * sizeof(ULONG) bytes of RAM
+#ifndef IOTC_COMPRESS_HASH_BITS
+#define IOTC_COMPRESS_HASH_BITS (10)
+#endif
+
+#define HASH_SIZE (1U << IOTC_COMPRESS_HASH_BITS)
+#define MIN_MATCH (3)
+#define MAX_MATCH (258)
+#define MAX_DISTANCE (32768)
+#define END_OF_BLOCK (256)
+
+#define GZIP_HEADER_SIZE (10)
+
+typedef struct {
+    UCHAR *buffer; // buffer mode only
+    IotConnectTelemetryPacket *tp; // packet mode only
+    UCHAR *chunk; // packet space returned by iothub_telemetry_packet_reserve()
+    size_t chunk_size;
+    size_t chunk_len;
+    size_t limit;
+    size_t total;
+    ULONG bits;
+    UINT bit_count;
+    bool overflow;
+} Output;
+
+static const USHORT length_base[] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const UCHAR length_extra[] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const USHORT distance_base[] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const UCHAR distance_extra[] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint32_t crc_table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+// Positions + 1 of the last occurrence of each 3 byte hash. 0 means none.
+static ULONG hash_head[HASH_SIZE];
+static TX_MUTEX compress_mutex;
+static size_t min_size = IOTC_COMPRESS_DEFAULT_MIN_SIZE;
+static bool is_initialized = false;
+
+static uint32_t crc32_update(uint32_t crc, const UCHAR *data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc_table[crc & 0xf];
+        crc = (crc >> 4) ^ crc_table[crc & 0xf];
+    }
+    return ~crc;
+}
+
+static void out_commit(Output *o) {
+    if (o->tp && o->chunk_len > 0) {
+        iothub_telemetry_packet_commit(o->tp, o->chunk_len);
+    }
+    o->chunk_len = 0;
+    o->chunk_size = 0;
+}
+
+static void out_byte(Output *o, UCHAR b) {
+    if (o->overflow) {
+        return;
+    }
+    if (o->total >= o->limit) {
+        o->overflow = true;
+        return;
+    }
+    if (o->tp) {
+        if (o->chunk_len >= o->chunk_size) {
+            out_commit(o);
+            o->chunk = iothub_telemetry_packet_reserve(o->tp, 1, &o->chunk_size);
+            if (!o->chunk) {
+                o->overflow = true;
+                return;
+            }
+        }
+        o->chunk[o->chunk_len++] = b;
+    } else {
+        o->buffer[o->total] = b;
+    }
+    o->total++;
+}
+
+static void out_u32(Output *o, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out_byte(o, (UCHAR) (value >> (8 * i)));
+    }
+}
+
+// Deflate packs bits starting from the least significant bit
+static void put_bits(Output *o, ULONG value, UINT count) {
+    o->bits |= value << o->bit_count;
+    o->bit_count += count;
+    while (o->bit_count >= 8) {
+        out_byte(o, (UCHAR) o->bits);
+        o->bits >>= 8;
+        o->bit_count -= 8;
+    }
+}
+
+static void flush_bits(Output *o) {
+    if (o->bit_count > 0) {
+        out_byte(o, (UCHAR) o->bits);
+    }
+    o->bits = 0;
+    o->bit_count = 0;
+}
+
+// Huffman codes are packed starting from the most significant bit
+static void put_code(Output *o, UINT code, UINT count) {
+    UINT reversed = 0;
+    for (UINT i = 0; i < count; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    put_bits(o, reversed, count);
+}
+
+// Fixed Huffman code of a literal/length symbol (RFC 1951 section 3.2.6)
+static void put_symbol(Output *o, UINT symbol) {
+    if (symbol < 144) {
+        put_code(o, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        put_code(o, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        put_code(o, symbol - 256, 7);
+    } else {
+        put_code(o, 0xc0 + symbol - 280, 8);
+    }
+}
+
+static void put_match(Output *o, UINT length, UINT distance) {
+    UINT i = sizeof(length_base) / sizeof(length_base[0]) - 1;
+    while (length_base[i] > length) {
+        i--;
+    }
+    put_symbol(o, 257 + i);
+    put_bits(o, length - length_base[i], length_extra[i]);
+
+    i = sizeof(distance_base) / sizeof(distance_base[0]) - 1;
+    while (distance_base[i] > distance) {
+        i--;
+    }
+    put_code(o, i, 5);
+    put_bits(o, distance - distance_base[i], distance_extra[i]);
+}
+
+static UINT hash3(const UCHAR *p) {
+    const uint32_t v = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+    return (UINT) ((uint32_t) (v * 2654435761U) >> (32 - IOTC_COMPRESS_HASH_BITS));
+}
+
+// Must be called with the mutex held
+static void deflate_locked(Output *o, const UCHAR *data, size_t len) {
+    size_t pos = 0;
+    memset(hash_head, 0, sizeof(hash_head));
+
+    put_bits(o, 1, 1); // final block
+    put_bits(o, 1, 2); // fixed Huffman codes
+    while (pos < len && !o->overflow) {
+        size_t match_len = 0;
+        size_t distance = 0;
+        if (pos + MIN_MATCH <= len) {
+            const UINT h = hash3(&data[pos]);
+            const ULONG candidate = hash_head[h];
+            hash_head[h] = (ULONG) pos + 1;
+            if (candidate > 0 && pos - (candidate - 1) <= MAX_DISTANCE) {
+                const UCHAR *match = &data[candidate - 1];
+                size_t max_len = len - pos;
+                if (max_len > MAX_MATCH) {
+                    max_len = MAX_MATCH;
+                }
+                while (match_len < max_len && match[match_len] == data[pos + match_len]) {
+                    match_len++;
+                }
+                distance = pos - (candidate - 1);
+            }
+        }
+        if (match_len >= MIN_MATCH) {
+            put_match(o, (UINT) match_len, (UINT) distance);
+            // index the positions inside the match, so that later data can refer to them
+            for (size_t i = pos + 1; i < pos + match_len && i + MIN_MATCH <= len; i++) {
+                hash_head[hash3(&data[i])] = (ULONG) i + 1;
+            }
+            pos += match_len;
+        } else {
+            put_symbol(o, data[pos]);
+            pos++;
+        }
+    }
+    put_symbol(o, END_OF_BLOCK);
+    flush_bits(o);
+}
+
+static UINT compress_gzip(Output *o, const void *data, size_t len, size_t *compressed_len) {
+    static const UCHAR gzip_header[GZIP_HEADER_SIZE] = {
+            0x1f, 0x8b, // magic
+            8,          // deflate
+            0,          // flags
+            0, 0, 0, 0, // no modification time
+            0,          // extra flags
+            0xff        // unknown OS
+    };
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
+    if (!data) {
+        return NX_INVALID_PARAMETERS;
+    }
+    tx_mutex_get(&compress_mutex, TX_WAIT_FOREVER);
+    for (size_t i = 0; i < sizeof(gzip_header); i++) {
+        out_byte(o, gzip_header[i]);
+    }
+    deflate_locked(o, (const UCHAR *) data, len);
+    tx_mutex_put(&compress_mutex);
+    out_u32(o, crc32_update(0, (const UCHAR *) data, len));
+    out_u32(o, (uint32_t) len);
+    out_commit(o);
+    if (o->overflow) {
+        return (o->tp && o->tp->status) ? o->tp->status : NX_SIZE_ERROR;
+    }
+    if (compressed_len) {
+        *compressed_len = o->total;
+    }
+    return NX_SUCCESS;
+}
+
+UINT iotc_compress_init(const IotConnectCompressConfig *c) {
+    UINT status;
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (!is_initialized) {
+        if ((status = tx_mutex_create(&compress_mutex, "IOTC Compress", TX_INHERIT))) {
+            printf("IOTC: Failed to create the compression mutex: 0x%x\r\n", status);
+            return status;
+        }
+        is_initialized = true;
+    }
+    min_size = c->min_size ? c->min_size : IOTC_COMPRESS_DEFAULT_MIN_SIZE;
+    return NX_SUCCESS;
+}
+
+static bool has_content_encoding(const IotConnectMessageProperties *properties) {
+    static const char prefix[] = IOTC_PROPERTY_CONTENT_ENCODING "=";
+    const size_t prefix_len = sizeof(prefix) - 1;
+    if (!properties) {
+        return false;
+    }
+    if (properties->formatted) {
+        const char *p = properties->formatted;
+        const char *end = properties->formatted + properties->formatted_len;
+        while (p + prefix_len <= end) {
+            if (0 == memcmp(p, prefix, prefix_len)) {
+                return true;
+            }
+            while (p < end && *p != '&') {
+                p++;
+            }
+            p++; // skip the '&'
+        }
+        return false;
+    }
+    for (size_t i = 0; i < properties->count; i++) {
+        if (0 == strcmp(properties->items[i].name, IOTC_PROPERTY_CONTENT_ENCODING)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool iotc_compress_should_compress(size_t len, const IotConnectMessageProperties *properties) {
+    return is_initialized && len >= min_size && !has_content_encoding(properties);
+}
+
+UINT iotc_compress_gzip(const void *data, size_t len, void *buffer, size_t buffer_size, size_t *compressed_len) {
+    Output o;
+    if (!buffer) {
+        return NX_INVALID_PARAMETERS;
+    }
+    memset(&o, 0, sizeof(o));
+    o.buffer = (UCHAR *) buffer;
+    o.limit = buffer_size;
+    return compress_gzip(&o, data, len, compressed_len);
+}
+
+UINT iotc_compress_gzip_packet(const void *data, size_t len, IotConnectTelemetryPacket *tp, size_t *compressed_len) {
+    Output o;
+    if (!tp) {
+        return NX_INVALID_PARAMETERS;
+    }
+    memset(&o, 0, sizeof(o));
+    o.tp = tp;
+    o.limit = len > 0 ? len - 1 : 0; // only worth it if it gets smaller
+    return compress_gzip(&o, data, len, compressed_len);
+}
+
+#endif // IOTC_ENABLE_COMPRESSION
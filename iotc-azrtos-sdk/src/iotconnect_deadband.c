@@ -0,0 +1,121 @@
+//
+// Copyright: Avnet 2026
+//
+
+#include <math.h>
+#include "iotconnect_deadband.h"
+
+static bool is_outside_deadband(const IotcDeadbandAttribute *a, double value) {
+    if (isnan(value) || isnan(a->last_sent)) {
+        return isnan(value) != isnan(a->last_sent);
+    }
+    const double delta = fabs(value - a->last_sent);
+    if (a->absolute <= 0 && a->percent <= 0) {
+        return delta > 0;
+    }
+    if (a->absolute > 0 && delta <= a->absolute) {
+        return false;
+    }
+    if (a->percent > 0 && delta <= fabs(a->last_sent) * a->percent / 100.0) {
+        return false;
+    }
+    return true;
+}
+
+static bool is_heartbeat_due(const IotcDeadbandFilter *f, const IotcDeadbandAttribute *a, ULONG now) {
+    if (0 == f->max_silence_ms || !a->has_value) {
+        return false;
+    }
+    return now - a->last_sent_ticks >= (ULONG) ((ULONG64) f->max_silence_ms * TX_TIMER_TICKS_PER_SECOND / 1000);
+}
+
+bool iotc_deadband_update(IotcDeadbandFilter *f, size_t index, double value) {
+    if (index >= f->count) {
+        return false;
+    }
+    IotcDeadbandAttribute *a = &f->attributes[index];
+    a->latest = value;
+    a->has_value = true;
+    if (!a->has_sent || is_outside_deadband(a, value)) {
+        a->is_significant = true;
+    } else {
+        a->suppressed_count++;
+    }
+    return a->is_significant;
+}
+
+bool iotc_deadband_should_send(IotcDeadbandFilter *f) {
+    const ULONG now = tx_time_get();
+    for (size_t i = 0; i < f->count; i++) {
+        const IotcDeadbandAttribute *a = &f->attributes[i];
+        if (a->is_significant || is_heartbeat_due(f, a, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool should_select(const IotcDeadbandFilter *f, const IotcDeadbandAttribute *a, ULONG now) {
+    if (!a->has_value) {
+        return false;
+    }
+    // Piggyback the suppressed values on a message that is going out anyway, so that the cloud
+    // has the latest values without sending more messages.
+    return a->is_significant || a->suppressed_count > 0 || is_heartbeat_due(f, a, now);
+}
+
+size_t iotc_deadband_select(IotcDeadbandFilter *f) {
+    size_t selected = 0;
+    f->selected_ticks = tx_time_get();
+    for (size_t i = 0; i < f->count; i++) {
+        IotcDeadbandAttribute *a = &f->attributes[i];
+        a->is_selected = should_select(f, a, f->selected_ticks);
+        if (a->is_selected) {
+            a->selected_value = a->latest;
+            selected++;
+        }
+    }
+    return selected;
+}
+
+bool iotc_deadband_is_selected(IotcDeadbandFilter *f, size_t index) {
+    if (index >= f->count) {
+        return false;
+    }
+    return f->attributes[index].is_selected;
+}
+
+static bool is_same_value(double a, double b) {
+    return (isnan(a) && isnan(b)) || a == b;
+}
+
+void iotc_deadband_commit(IotcDeadbandFilter *f) {
+    for (size_t i = 0; i < f->count; i++) {
+        IotcDeadbandAttribute *a = &f->attributes[i];
+        if (!a->is_selected) {
+            continue;
+        }
+        a->is_selected = false;
+        a->last_sent = a->selected_value;
+        a->last_sent_ticks = f->selected_ticks;
+        a->has_sent = true;
+        // a value that arrived after the selection was not sent, so it needs to be evaluated again
+        if (is_same_value(a->latest, a->selected_value)) {
+            a->suppressed_count = 0;
+            a->is_significant = false;
+        } else {
+            a->is_significant = is_outside_deadband(a, a->latest);
+            a->suppressed_count = a->is_significant ? 0 : 1;
+        }
+    }
+}
+
+size_t iotc_deadband_write(IotcDeadbandFilter *f, IotcJsonWriter *w) {
+    size_t written = iotc_deadband_select(f);
+    for (size_t i = 0; i < f->count; i++) {
+        if (f->attributes[i].is_selected) {
+            iotc_json_set_number(w, f->attributes[i].name, f->attributes[i].selected_value);
+        }
+    }
+    return w->overflow ? 0 : written;
+}
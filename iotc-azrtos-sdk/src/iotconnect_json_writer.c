@@ -0,0 +1,244 @@
+//
+// Copyright: Avnet 2026
+//
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "iotconnect_lib.h"
+#include "iotconnect_lib_config.h"
+#include "azrtos_time.h"
+#include "iotconnect_json_writer.h"
+
+void iotc_json_init_buffer(IotcJsonWriter *w, char *buffer, size_t size) {
+    memset(w, 0, sizeof(IotcJsonWriter));
+    w->buffer = buffer;
+    w->size = size;
+    if (0 == size) {
+        w->overflow = true;
+    } else {
+        buffer[0] = 0;
+    }
+}
+
+void iotc_json_init_packet(IotcJsonWriter *w, IotConnectTelemetryPacket *tp) {
+    memset(w, 0, sizeof(IotcJsonWriter));
+    w->tp = tp;
+}
+
+void iotc_json_raw(IotcJsonWriter *w, const char *str, size_t len) {
+    if (w->overflow) {
+        return;
+    }
+    if (w->tp) {
+        if (iothub_telemetry_packet_write(w->tp, str, len)) {
+            w->overflow = true;
+            return;
+        }
+    } else {
+        if (w->len + len >= w->size) {
+            w->overflow = true;
+            return;
+        }
+        memcpy(&w->buffer[w->len], str, len);
+        w->buffer[w->len + len] = 0;
+    }
+    w->len += len;
+}
+
+static void json_put_str(IotcJsonWriter *w, const char *str) {
+    iotc_json_raw(w, str, strlen(str));
+}
+
+static void json_value_prefix(IotcJsonWriter *w) {
+    if (w->need_comma) {
+        iotc_json_raw(w, ",", 1);
+    }
+    w->need_comma = true;
+}
+
+void iotc_json_object_begin(IotcJsonWriter *w) {
+    json_value_prefix(w);
+    iotc_json_raw(w, "{", 1);
+    w->need_comma = false;
+}
+
+void iotc_json_object_end(IotcJsonWriter *w) {
+    iotc_json_raw(w, "}", 1);
+    w->need_comma = true;
+}
+
+void iotc_json_array_begin(IotcJsonWriter *w) {
+    json_value_prefix(w);
+    iotc_json_raw(w, "[", 1);
+    w->need_comma = false;
+}
+
+void iotc_json_array_end(IotcJsonWriter *w) {
+    iotc_json_raw(w, "]", 1);
+    w->need_comma = true;
+}
+
+// quoted and escaped string, without the comma handling
+static void json_put_quoted(IotcJsonWriter *w, const char *str) {
+    char escape_buff[7];
+    const char *run_start = str;
+    iotc_json_raw(w, "\"", 1);
+    for (const char *p = str; *p; p++) {
+        const unsigned char ch = (unsigned char) *p;
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+        iotc_json_raw(w, run_start, p - run_start);
+        run_start = p + 1;
+        switch (ch) {
+        case '"': iotc_json_raw(w, "\\\"", 2); break;
+        case '\\': iotc_json_raw(w, "\\\\", 2); break;
+        case '\n': iotc_json_raw(w, "\\n", 2); break;
+        case '\r': iotc_json_raw(w, "\\r", 2); break;
+        case '\t': iotc_json_raw(w, "\\t", 2); break;
+        default:
+            sprintf(escape_buff, "\\u%04x", ch);
+            iotc_json_raw(w, escape_buff, 6);
+            break;
+        }
+    }
+    json_put_str(w, run_start);
+    iotc_json_raw(w, "\"", 1);
+}
+
+void iotc_json_key(IotcJsonWriter *w, const char *name) {
+    json_value_prefix(w);
+    json_put_quoted(w, name);
+    iotc_json_raw(w, ":", 1);
+    w->need_comma = false;
+}
+
+void iotc_json_key_raw(IotcJsonWriter *w, const char *quoted_key, size_t len) {
+    json_value_prefix(w);
+    iotc_json_raw(w, quoted_key, len);
+    w->need_comma = false;
+}
+
+void iotc_json_string(IotcJsonWriter *w, const char *str) {
+    json_value_prefix(w);
+    json_put_quoted(w, str);
+}
+
+void iotc_json_number(IotcJsonWriter *w, double value) {
+    char number_buff[26];
+    if (isnan(value) || isinf(value)) {
+        strcpy(number_buff, "null");
+    } else if (fabs(value) < 1.0e15 && value == (double) (long long) value) {
+        sprintf(number_buff, "%lld", (long long) value);
+    } else {
+        sprintf(number_buff, "%1.15g", value);
+        if (strtod(number_buff, NULL) != value) {
+            sprintf(number_buff, "%1.17g", value);
+        }
+    }
+    json_value_prefix(w);
+    json_put_str(w, number_buff);
+}
+
+void iotc_json_bool(IotcJsonWriter *w, bool value) {
+    json_value_prefix(w);
+    json_put_str(w, value ? "true" : "false");
+}
+
+void iotc_json_null(IotcJsonWriter *w) {
+    json_value_prefix(w);
+    iotc_json_raw(w, "null", 4);
+}
+
+bool iotc_json_set_number(IotcJsonWriter *w, const char *name, double value) {
+    if (!name) {
+        return false;
+    }
+    iotc_json_key(w, name);
+    iotc_json_number(w, value);
+    return !w->overflow;
+}
+
+bool iotc_json_set_string(IotcJsonWriter *w, const char *name, const char *value) {
+    if (!name) {
+        return false;
+    }
+    iotc_json_key(w, name);
+    if (value) {
+        iotc_json_string(w, value);
+    } else {
+        iotc_json_null(w);
+    }
+    return !w->overflow;
+}
+
+bool iotc_json_set_bool(IotcJsonWriter *w, const char *name, bool value) {
+    if (!name) {
+        return false;
+    }
+    iotc_json_key(w, name);
+    iotc_json_bool(w, value);
+    return !w->overflow;
+}
+
+bool iotc_json_set_null(IotcJsonWriter *w, const char *name) {
+    if (!name) {
+        return false;
+    }
+    iotc_json_key(w, name);
+    iotc_json_null(w);
+    return !w->overflow;
+}
+
+bool iotc_json_telemetry_begin(IotcJsonWriter *w) {
+    char now[UNIX_TIME_ISO_BUFFER_SIZE];
+    IotclConfig *lc = iotcl_get_config();
+    if (!lc) {
+        printf("IOTC: The IoTConnect Lib is not initialized\r\n");
+        return false;
+    }
+    iotc_json_object_begin(w);
+    iotc_json_set_string(w, "cpId", lc->device.cpid);
+    iotc_json_set_string(w, "dtg", lc->telemetry.dtg);
+    iotc_json_set_string(w, "t", unix_time_iso_now(now, sizeof(now)));
+    iotc_json_set_number(w, "mt", 0);
+    iotc_json_key(w, "sdk");
+    iotc_json_object_begin(w);
+    iotc_json_set_string(w, "l", CONFIG_IOTCONNECT_SDK_NAME);
+    iotc_json_set_string(w, "v", CONFIG_IOTCONNECT_SDK_VERSION);
+    iotc_json_set_string(w, "e", lc->device.env);
+    iotc_json_object_end(w);
+    iotc_json_key(w, "d");
+    iotc_json_array_begin(w);
+    return !w->overflow;
+}
+
+bool iotc_json_telemetry_record_begin(IotcJsonWriter *w, const char *iso_time) {
+    char now[UNIX_TIME_ISO_BUFFER_SIZE];
+    IotclConfig *lc = iotcl_get_config();
+    if (!lc) {
+        printf("IOTC: The IoTConnect Lib is not initialized\r\n");
+        return false;
+    }
+    iotc_json_object_begin(w);
+    iotc_json_set_string(w, "id", lc->device.duid);
+    iotc_json_set_string(w, "tg", "");
+    iotc_json_set_string(w, "dt", iso_time ? iso_time : unix_time_iso_now(now, sizeof(now)));
+    iotc_json_key(w, "d");
+    iotc_json_object_begin(w);
+    return !w->overflow;
+}
+
+bool iotc_json_telemetry_record_end(IotcJsonWriter *w) {
+    iotc_json_object_end(w); // "d"
+    iotc_json_object_end(w); // record
+    return !w->overflow;
+}
+
+bool iotc_json_telemetry_end(IotcJsonWriter *w) {
+    iotc_json_array_end(w); // "d"
+    iotc_json_object_end(w);
+    return !w->overflow;
+}
@@ -0,0 +1,476 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_OFFLINE_QUEUE
+
+#include <string.h>
+#include <stdio.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "azrtos_iothub_client.h"
+#include "iotconnect_record_ring.h"
+#include "iotconnect_rate_limit.h"
+#include "iotconnect_offline.h"
+
+#ifndef IOTC_OFFLINE_BUFFER_SIZE
+#define IOTC_OFFLINE_BUFFER_SIZE (4 * 1024)
+#endif
+
+// Largest message that can be stored. A buffer of this size is used to send the messages from the backlog.
+#ifndef IOTC_OFFLINE_MAX_MESSAGE_SIZE
+#define IOTC_OFFLINE_MAX_MESSAGE_SIZE (1024)
+#endif
+
+// Largest encoded message properties string that can be stored with a message
+#ifndef IOTC_OFFLINE_MAX_PROPERTIES_SIZE
+#define IOTC_OFFLINE_MAX_PROPERTIES_SIZE (128)
+#endif
+
+#ifndef IOTC_OFFLINE_DRAIN_MAX_MESSAGES
+#define IOTC_OFFLINE_DRAIN_MAX_MESSAGES (10)
+#endif
+
+#ifndef IOTC_OFFLINE_DEFAULT_FILE_NAME
+#define IOTC_OFFLINE_DEFAULT_FILE_NAME "IOTCQ.BIN"
+#endif
+
+// Once the RAM buffer holds more than this many bytes, iotc_offline_drain() moves the oldest messages into the file
+#ifndef IOTC_OFFLINE_SPILL_THRESHOLD
+#define IOTC_OFFLINE_SPILL_THRESHOLD (IOTC_OFFLINE_BUFFER_SIZE / 2)
+#endif
+
+// The progress of sending the file is written and the media is flushed at most this often, in order to reduce flash wear.
+// Messages moved into the file are always flushed right away.
+#ifndef IOTC_OFFLINE_FILE_SYNC_INTERVAL_MS
+#define IOTC_OFFLINE_FILE_SYNC_INTERVAL_MS (10 * 1000)
+#endif
+
+// The encoded message properties follow the message data
+typedef struct {
+    ULONG len;
+    ULONG properties_len;
+    UCHAR data[];
+} OfflineRecord;
+
+static ULONG ring_buffer[IOTC_OFFLINE_BUFFER_SIZE / sizeof(ULONG)];
+static UCHAR drain_buffer[IOTC_OFFLINE_MAX_MESSAGE_SIZE + IOTC_OFFLINE_MAX_PROPERTIES_SIZE];
+static IotcRecordRing ring;
+static TX_MUTEX offline_mutex;
+static IotConnectOfflineConfig config = { 0 };
+static bool is_initialized = false;
+
+static ULONG window_start_ticks = 0;
+static UINT window_count = 0;
+
+// The oldest RAM message stays in the ring while it is being sent or moved into the file, so that a failure keeps the order.
+// If the producers need to evict it in the meantime, the drain must not pop the ring afterwards.
+static bool is_head_in_flight = false;
+
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+
+#define FILE_MAGIC 0x32514f49UL // "IOQ2"
+
+// Stored at the beginning of the file. Each message that follows is prefixed with its ULONG length
+// and the ULONG length of its encoded properties, which follow the message data.
+// The header is only synced periodically. The count is recomputed from the records when the file is opened,
+// so after a power loss at most the messages sent since the last sync are sent again.
+// The file is only accessed by the thread that calls iotc_offline_drain(), so the producers never wait for the media.
+typedef struct {
+    ULONG magic;
+    ULONG read_offset; // offset of the oldest message that was not sent yet
+    ULONG count;
+} FileHeader;
+
+static FX_FILE file;
+static bool is_file_open = false;
+static FileHeader file_header;
+static ULONG file_size = 0;
+static bool is_header_dirty = false;
+static ULONG header_sync_ticks = 0;
+
+static UINT file_write_header(void) {
+    UINT status;
+    if ((status = fx_file_seek(&file, 0))
+            || (status = fx_file_write(&file, &file_header, sizeof(file_header)))
+            || (status = fx_media_flush(config.media))) {
+        printf("IOTC: Offline: Failed to write the file header. Error: 0x%x\r\n", status);
+        return status;
+    }
+    is_header_dirty = false;
+    header_sync_ticks = tx_time_get();
+    return NX_SUCCESS;
+}
+
+// Writes the header if it changed and the sync interval elapsed
+static void file_sync(void) {
+    if (!is_file_open || !is_header_dirty) {
+        return;
+    }
+    if (tx_time_get() - header_sync_ticks >= (ULONG) IOTC_OFFLINE_FILE_SYNC_INTERVAL_MS * TX_TIMER_TICKS_PER_SECOND / 1000) {
+        file_write_header();
+    }
+}
+
+// Walks the records after read_offset. Stops at a partially written record, which is then overwritten.
+static void file_count_records(void) {
+    ULONG offset = file_header.read_offset;
+    ULONG count = 0;
+    while (offset + 2 * sizeof(ULONG) <= file_size) {
+        ULONG lengths[2];
+        ULONG actual_size;
+        if (fx_file_seek(&file, offset)
+                || fx_file_read(&file, lengths, sizeof(lengths), &actual_size)
+                || sizeof(lengths) != actual_size
+                || lengths[0] > IOTC_OFFLINE_MAX_MESSAGE_SIZE
+                || lengths[1] > IOTC_OFFLINE_MAX_PROPERTIES_SIZE
+                || offset + sizeof(lengths) + lengths[0] + lengths[1] > file_size) {
+            break;
+        }
+        offset += sizeof(lengths) + lengths[0] + lengths[1];
+        count++;
+    }
+    file_size = offset;
+    if (count != file_header.count) {
+        file_header.count = count;
+        is_header_dirty = true;
+    }
+}
+
+static UINT file_reset(void) {
+    UINT status;
+    if ((status = fx_file_truncate_release(&file, 0))) {
+        printf("IOTC: Offline: Failed to truncate the file. Error: 0x%x\r\n", status);
+        return status;
+    }
+    file_header.magic = FILE_MAGIC;
+    file_header.read_offset = sizeof(FileHeader);
+    file_header.count = 0;
+    file_size = sizeof(FileHeader);
+    return file_write_header();
+}
+
+static UINT file_open(void) {
+    UINT status;
+    ULONG actual_size;
+    CHAR *file_name = config.file_name ? config.file_name : IOTC_OFFLINE_DEFAULT_FILE_NAME;
+
+    status = fx_file_create(config.media, file_name);
+    if (status && FX_ALREADY_CREATED != status) {
+        printf("IOTC: Offline: Failed to create %s. Error: 0x%x\r\n", file_name, status);
+        return status;
+    }
+    if ((status = fx_file_open(config.media, &file, file_name, FX_OPEN_FOR_WRITE))) {
+        printf("IOTC: Offline: Failed to open %s. Error: 0x%x\r\n", file_name, status);
+        return status;
+    }
+    is_file_open = true;
+    file_size = (ULONG) file.fx_file_current_file_size;
+    if (file_size >= sizeof(FileHeader)
+            && FX_SUCCESS == fx_file_read(&file, &file_header, sizeof(file_header), &actual_size)
+            && sizeof(file_header) == actual_size
+            && FILE_MAGIC == file_header.magic
+            && file_header.read_offset >= sizeof(FileHeader)
+            && file_header.read_offset <= file_size) {
+        file_count_records();
+        if (file_header.count > 0) {
+            printf("IOTC: Offline: %lu messages found in %s\r\n", file_header.count, file_name);
+        }
+        return NX_SUCCESS;
+    }
+    return file_reset();
+}
+
+static UINT file_append(const void *data, ULONG len, ULONG properties_len) {
+    UINT status;
+    const ULONG record_size = 2 * sizeof(ULONG) + len + properties_len;
+    if (config.max_file_size > 0 && file_size + record_size > config.max_file_size) {
+        return NX_OVERFLOW;
+    }
+    if ((status = fx_file_seek(&file, file_size))
+            || (status = fx_file_write(&file, &len, sizeof(len)))
+            || (status = fx_file_write(&file, &properties_len, sizeof(properties_len)))
+            || (status = fx_file_write(&file, (VOID *) data, len + properties_len))) {
+        printf("IOTC: Offline: Failed to write to the file. Error: 0x%x\r\n", status);
+        return status;
+    }
+    file_size += record_size;
+    is_header_dirty = true;
+    return NX_SUCCESS;
+}
+
+static UINT file_read_oldest(void *buffer, ULONG buffer_size, ULONG *len, ULONG *properties_len) {
+    UINT status;
+    ULONG actual_size;
+    ULONG properties_actual_size;
+    if (!is_file_open || 0 == file_header.count || file_header.read_offset >= file_size) {
+        return NX_NOT_FOUND;
+    }
+    if ((status = fx_file_seek(&file, file_header.read_offset))
+            || (status = fx_file_read(&file, len, sizeof(ULONG), &actual_size))
+            || (status = fx_file_read(&file, properties_len, sizeof(ULONG), &properties_actual_size))) {
+        return status;
+    }
+    if (sizeof(ULONG) != actual_size || sizeof(ULONG) != properties_actual_size
+            || *len > buffer_size || *properties_len > buffer_size - *len) {
+        printf("IOTC: Offline: The file is corrupted. Discarding the backlog.\r\n");
+        file_reset();
+        return NX_NOT_FOUND;
+    }
+    if ((status = fx_file_read(&file, buffer, *len + *properties_len, &actual_size))) {
+        return status;
+    }
+    return (actual_size == *len + *properties_len) ? NX_SUCCESS : NX_NOT_FOUND;
+}
+
+static void file_remove_oldest(ULONG record_len) {
+    file_header.read_offset += 2 * sizeof(ULONG) + record_len;
+    file_header.count--;
+    if (0 == file_header.count || file_header.read_offset >= file_size) {
+        file_reset(); // reclaim the space
+    } else {
+        is_header_dirty = true;
+    }
+}
+
+// Moves the oldest messages from the RAM buffer into the file until it is no more than IOTC_OFFLINE_SPILL_THRESHOLD full.
+// The file is written without holding the mutex, and flushed once the messages are moved.
+static void file_spill(void) {
+    bool is_spilled = false;
+    while (is_file_open) {
+        UINT status;
+        ULONG len;
+        ULONG properties_len;
+
+        tx_mutex_get(&offline_mutex, TX_WAIT_FOREVER);
+        OfflineRecord *record = (OfflineRecord *) iotc_record_ring_peek(&ring, NULL);
+        if (!record || iotc_record_ring_used(&ring) <= IOTC_OFFLINE_SPILL_THRESHOLD) {
+            tx_mutex_put(&offline_mutex);
+            break;
+        }
+        len = record->len;
+        properties_len = record->properties_len;
+        memcpy(drain_buffer, record->data, len + properties_len);
+        is_head_in_flight = true;
+        tx_mutex_put(&offline_mutex);
+
+        status = file_append(drain_buffer, len, properties_len);
+
+        tx_mutex_get(&offline_mutex, TX_WAIT_FOREVER);
+        if (!status) {
+            file_header.count++;
+            if (is_head_in_flight) {
+                iotc_record_ring_pop(&ring);
+            }
+        }
+        is_head_in_flight = false;
+        tx_mutex_put(&offline_mutex);
+        if (status) {
+            break; // the file is full or failing. The producers will discard the oldest messages.
+        }
+        is_spilled = true;
+    }
+    if (is_spilled) {
+        file_write_header();
+    }
+}
+
+#endif // IOTC_ENABLE_OFFLINE_FILEX
+
+// Makes room in the RAM buffer by discarding the oldest message. Must be called with the mutex held
+static void evict_oldest_locked(void) {
+    if (!iotc_record_ring_peek(&ring, NULL)) {
+        return;
+    }
+    if (is_head_in_flight) {
+        // the drain is still sending it or moving it into the file
+        is_head_in_flight = false;
+    } else {
+        printf("IOTC: Offline: Backlog is full. Discarding the oldest message.\r\n");
+    }
+    iotc_record_ring_pop(&ring);
+}
+
+static bool drain_rate_allows(void) {
+    if (0 == config.drain_messages_per_second) {
+        return true;
+    }
+    ULONG now = tx_time_get();
+    if (now - window_start_ticks >= TX_TIMER_TICKS_PER_SECOND) {
+        window_start_ticks = now;
+        window_count = 0;
+    }
+    return window_count < config.drain_messages_per_second;
+}
+
+UINT iotc_offline_init(const IotConnectOfflineConfig *c) {
+    UINT status;
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (is_initialized) {
+        // only the rate can be changed at runtime
+        config.drain_messages_per_second = c->drain_messages_per_second;
+        return NX_SUCCESS;
+    }
+    memcpy(&config, c, sizeof(config));
+    iotc_record_ring_init(&ring, ring_buffer, sizeof(ring_buffer));
+    if ((status = tx_mutex_create(&offline_mutex, "IOTC Offline", TX_INHERIT))) {
+        printf("IOTC: Failed to create the offline queue mutex: 0x%x\r\n", status);
+        return status;
+    }
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+    if (config.media && file_open()) {
+        printf("IOTC: Offline: Continuing without a file\r\n");
+    }
+#endif
+    is_initialized = true;
+    return NX_SUCCESS;
+}
+
+bool iotc_offline_is_enabled(void) {
+    return is_initialized;
+}
+
+UINT iotc_offline_store(const void *data, size_t len, const IotConnectMessageProperties *properties) {
+    char properties_buffer[IOTC_OFFLINE_MAX_PROPERTIES_SIZE];
+    const char *encoded_properties = NULL;
+    size_t properties_len = 0;
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
+    if (!data || 0 == len) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (len > IOTC_OFFLINE_MAX_MESSAGE_SIZE) {
+        printf("IOTC: Offline: Message of %u bytes exceeds IOTC_OFFLINE_MAX_MESSAGE_SIZE\r\n", (unsigned int) len);
+        return NX_SIZE_ERROR;
+    }
+    if (properties && properties->formatted) {
+        encoded_properties = properties->formatted;
+        properties_len = properties->formatted_len;
+    } else if (properties && properties->count > 0) {
+        if (iothub_message_properties_encode(properties->items, properties->count,
+                properties_buffer, sizeof(properties_buffer), &properties_len)) {
+            properties_len = sizeof(properties_buffer); // fails the size check below
+        }
+        encoded_properties = properties_buffer;
+    }
+    if (properties_len > IOTC_OFFLINE_MAX_PROPERTIES_SIZE) {
+        printf("IOTC: Offline: Message properties exceed IOTC_OFFLINE_MAX_PROPERTIES_SIZE\r\n");
+        return NX_SIZE_ERROR;
+    }
+
+    tx_mutex_get(&offline_mutex, TX_WAIT_FOREVER);
+    OfflineRecord *record;
+    while (NULL == (record = (OfflineRecord *) iotc_record_ring_push(&ring,
+            sizeof(OfflineRecord) + len + properties_len))) {
+        if (0 == iotc_record_ring_count(&ring)) {
+            tx_mutex_put(&offline_mutex);
+            return NX_SIZE_ERROR; // will never fit
+        }
+        evict_oldest_locked();
+    }
+    record->len = (ULONG) len;
+    record->properties_len = (ULONG) properties_len;
+    memcpy(record->data, data, len);
+    if (properties_len > 0) {
+        memcpy(&record->data[len], encoded_properties, properties_len);
+    }
+    tx_mutex_put(&offline_mutex);
+    return NX_SUCCESS;
+}
+
+UINT iotc_offline_drain(void) {
+    UINT status = NX_SUCCESS;
+    if (!is_initialized) {
+        return NX_SUCCESS;
+    }
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+    file_spill();
+#endif
+    for (int i = 0; i < IOTC_OFFLINE_DRAIN_MAX_MESSAGES; i++) {
+        if (!iothub_client_is_connected() || !drain_rate_allows()) {
+            break;
+        }
+        ULONG len = 0;
+        ULONG properties_len = 0;
+        bool from_file = false;
+
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+        // the file always holds older messages than the RAM buffer
+        from_file = (NX_SUCCESS == file_read_oldest(drain_buffer, sizeof(drain_buffer), &len, &properties_len));
+#endif
+        tx_mutex_get(&offline_mutex, TX_WAIT_FOREVER);
+        OfflineRecord *record = NULL;
+        if (!from_file) {
+            record = (OfflineRecord *) iotc_record_ring_peek(&ring, NULL);
+            if (!record) {
+                tx_mutex_put(&offline_mutex);
+                break;
+            }
+            len = record->len;
+            properties_len = record->properties_len;
+        }
+#ifdef IOTC_ENABLE_RATE_LIMIT
+        // The backlog is never dropped because of the rate limit. Try again on the next poll.
+        if (iotc_rate_limit_acquire(len, 0)) {
+            tx_mutex_put(&offline_mutex);
+            break;
+        }
+#endif
+        if (!from_file) {
+            // Send a copy so that we do not block the producers while sending.
+            // The record is popped only once it is sent.
+            memcpy(drain_buffer, record->data, len + properties_len);
+            is_head_in_flight = true;
+        }
+        tx_mutex_put(&offline_mutex);
+
+        IotConnectMessageProperties properties = {
+                .formatted = (const char *) &drain_buffer[len],
+                .formatted_len = properties_len
+        };
+        status = iothub_send_message_n(drain_buffer, len, properties_len ? &properties : NULL);
+
+        if (!from_file) {
+            tx_mutex_get(&offline_mutex, TX_WAIT_FOREVER);
+            if (!status && is_head_in_flight) {
+                iotc_record_ring_pop(&ring);
+            }
+            is_head_in_flight = false;
+            tx_mutex_put(&offline_mutex);
+        }
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+        else if (!status) {
+            file_remove_oldest(len + properties_len);
+        }
+#endif
+
+        if (status) {
+            printf("IOTC: Offline: Failed to send a stored message. Error: 0x%x\r\n", status);
+            break;
+        }
+        window_count++;
+    }
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+    file_sync();
+#endif
+    return status;
+}
+
+ULONG iotc_offline_count(void) {
+    ULONG count;
+    if (!is_initialized) {
+        return 0;
+    }
+    tx_mutex_get(&offline_mutex, TX_WAIT_FOREVER);
+    count = (ULONG) iotc_record_ring_count(&ring);
+#ifdef IOTC_ENABLE_OFFLINE_FILEX
+    count += file_header.count; // a single word, written by the draining thread
+#endif
+    tx_mutex_put(&offline_mutex);
+    return count;
+}
+
+#endif // IOTC_ENABLE_OFFLINE_QUEUE
@@ -0,0 +1,163 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_RATE_LIMIT
+
+#include <string.h>
+#include <stdio.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "iotconnect_rate_limit.h"
+
+// Token counts are scaled by TX_TIMER_TICKS_PER_SECOND, so that refilling by elapsed ticks
+// does not lose the fractions: one tick adds exactly "rate" scaled tokens.
+typedef struct {
+    ULONG64 tokens;
+    ULONG64 capacity; // 0 means no limit
+    ULONG rate;
+} Bucket;
+
+static Bucket messages;
+static Bucket bytes;
+static ULONG last_refill_ticks;
+static IotConnectRateLimitConfig config = { 0 };
+static TX_MUTEX limit_mutex;
+static bool is_initialized = false;
+
+static void bucket_init(Bucket *b, ULONG rate, ULONG burst) {
+    b->rate = rate;
+    if (0 == rate) {
+        b->capacity = 0;
+    } else {
+        b->capacity = (ULONG64) (burst ? burst : rate) * TX_TIMER_TICKS_PER_SECOND;
+    }
+    b->tokens = b->capacity;
+}
+
+static void bucket_refill(Bucket *b, ULONG elapsed_ticks) {
+    if (0 == b->capacity) {
+        return;
+    }
+    b->tokens += (ULONG64) elapsed_ticks * b->rate;
+    if (b->tokens > b->capacity) {
+        b->tokens = b->capacity;
+    }
+}
+
+// Returns the number of ticks until the bucket has the amount, or 0 if it has it now.
+static ULONG bucket_ticks_needed(const Bucket *b, ULONG64 amount) {
+    if (0 == b->capacity) {
+        return 0;
+    }
+    if (amount > b->capacity) {
+        amount = b->capacity; // an oversized message goes through once the bucket is full
+    }
+    if (b->tokens >= amount) {
+        return 0;
+    }
+    return (ULONG) ((amount - b->tokens + b->rate - 1) / b->rate);
+}
+
+static void bucket_take(Bucket *b, ULONG64 amount) {
+    if (0 == b->capacity) {
+        return;
+    }
+    b->tokens = (amount > b->tokens) ? 0 : b->tokens - amount;
+}
+
+// Must be called with the mutex held. Returns 0 if the tokens were taken.
+static ULONG try_take_locked(size_t len) {
+    const ULONG now = tx_time_get();
+    const ULONG elapsed = now - last_refill_ticks;
+    last_refill_ticks = now;
+    bucket_refill(&messages, elapsed);
+    bucket_refill(&bytes, elapsed);
+
+    const ULONG64 message_amount = TX_TIMER_TICKS_PER_SECOND;
+    const ULONG64 byte_amount = (ULONG64) len * TX_TIMER_TICKS_PER_SECOND;
+    ULONG wait_messages = bucket_ticks_needed(&messages, message_amount);
+    ULONG wait_bytes = bucket_ticks_needed(&bytes, byte_amount);
+    if (0 == wait_messages && 0 == wait_bytes) {
+        bucket_take(&messages, message_amount);
+        bucket_take(&bytes, byte_amount);
+        return 0;
+    }
+    return wait_messages > wait_bytes ? wait_messages : wait_bytes;
+}
+
+UINT iotc_rate_limit_init(const IotConnectRateLimitConfig *c) {
+    UINT status;
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (!is_initialized) {
+        if ((status = tx_mutex_create(&limit_mutex, "IOTC Rate Limit", TX_INHERIT))) {
+            printf("IOTC: Failed to create the rate limit mutex: 0x%x\r\n", status);
+            return status;
+        }
+        is_initialized = true;
+    }
+    if (IOTC_RATE_LIMIT_DROP_OLDEST == c->policy) {
+        printf("IOTC: Rate limit: IOTC_RATE_LIMIT_DROP_OLDEST only applies to the send queue. Direct sends will fail.\r\n");
+    }
+    tx_mutex_get(&limit_mutex, TX_WAIT_FOREVER);
+    memcpy(&config, c, sizeof(config));
+    bucket_init(&messages, config.messages_per_second, config.burst_messages);
+    bucket_init(&bytes, config.bytes_per_second, config.burst_bytes);
+    last_refill_ticks = tx_time_get();
+    tx_mutex_put(&limit_mutex);
+    return NX_SUCCESS;
+}
+
+IotConnectRateLimitPolicy iotc_rate_limit_get_policy(void) {
+    return config.policy;
+}
+
+UINT iotc_rate_limit_try_acquire(size_t len, ULONG *ticks_needed) {
+    *ticks_needed = 0;
+    if (!is_initialized) {
+        return NX_SUCCESS;
+    }
+    tx_mutex_get(&limit_mutex, TX_WAIT_FOREVER);
+    *ticks_needed = try_take_locked(len);
+    tx_mutex_put(&limit_mutex);
+    return (0 == *ticks_needed) ? NX_SUCCESS : NX_NO_MORE_ENTRIES;
+}
+
+UINT iotc_rate_limit_acquire(size_t len, ULONG wait_ticks) {
+    if (!is_initialized) {
+        return NX_SUCCESS;
+    }
+    const ULONG start = tx_time_get();
+    while (true) {
+        tx_mutex_get(&limit_mutex, TX_WAIT_FOREVER);
+        ULONG ticks_needed = try_take_locked(len);
+        tx_mutex_put(&limit_mutex);
+        if (0 == ticks_needed) {
+            return NX_SUCCESS;
+        }
+        if (TX_WAIT_FOREVER != wait_ticks) {
+            const ULONG waited = tx_time_get() - start;
+            if (waited + ticks_needed > wait_ticks) {
+                return NX_NO_MORE_ENTRIES;
+            }
+        }
+        tx_thread_sleep(ticks_needed);
+    }
+}
+
+UINT iotc_rate_limit_admit(size_t len) {
+    if (!is_initialized) {
+        return NX_SUCCESS;
+    }
+    if (IOTC_RATE_LIMIT_BLOCK == config.policy) {
+        return iotc_rate_limit_acquire(len, config.block_timeout_ms * TX_TIMER_TICKS_PER_SECOND / 1000);
+    }
+    if (IOTC_RATE_LIMIT_DROP_OLDEST == config.policy) {
+        return NX_NOT_SUPPORTED; // nothing older to drop
+    }
+    return iotc_rate_limit_acquire(len, 0);
+}
+
+#endif // IOTC_ENABLE_RATE_LIMIT
@@ -0,0 +1,285 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_RECONNECT
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "nx_azure_iot_hub_client.h"
+#include "azrtos_iothub_client.h"
+#include "iotconnect_reconnect.h"
+
+#ifndef IOTC_RECONNECT_DEFAULT_INITIAL_DELAY_MS
+#define IOTC_RECONNECT_DEFAULT_INITIAL_DELAY_MS (2000)
+#endif
+
+#ifndef IOTC_RECONNECT_DEFAULT_MAX_DELAY_MS
+#define IOTC_RECONNECT_DEFAULT_MAX_DELAY_MS (300000)
+#endif
+
+// The MQTT connect, including the TLS handshake, runs on this thread
+#ifndef IOTC_RECONNECT_STACK_SIZE
+#define IOTC_RECONNECT_STACK_SIZE (6 * 1024)
+#endif
+
+#ifndef IOTC_RECONNECT_THREAD_PRIORITY
+#define IOTC_RECONNECT_THREAD_PRIORITY (6)
+#endif
+
+// How often to check for a cancel while the application thread runs an attempt
+#define ATTEMPT_POLL_TICKS (TX_TIMER_TICKS_PER_SECOND)
+
+typedef enum {
+    RECOVERY_RECONNECT,     // reconnect after the backoff delay
+    RECOVERY_IMMEDIATE,     // reconnect right away
+    RECOVERY_SYNC           // run discovery and sync, then connect
+} Recovery;
+
+static ULONG reconnect_thread_stack[IOTC_RECONNECT_STACK_SIZE / sizeof(ULONG)];
+static TX_THREAD reconnect_thread;
+static TX_SEMAPHORE start_sem;
+static TX_SEMAPHORE cancel_sem;
+static TX_SEMAPHORE attempt_done_sem;
+static TX_MUTEX attempt_mutex; // held while a connect attempt is in progress on the reconnect thread
+static IotConnectReconnectConfig config = { 0 };
+static IotConnectStatusCallback status_cb = NULL;
+static volatile IotConnectReconnectState state = IOTC_RECONNECT_IDLE;
+static volatile bool is_cancelled = false;
+static UINT start_reason = NX_SUCCESS;
+static bool is_initialized = false;
+
+// An attempt that runs from iotconnect_sdk_poll() on the application thread
+static volatile bool is_attempt_pending = false;
+static bool is_pending_attempt_resync = false;
+static UINT pending_attempt_status = NX_SUCCESS;
+
+static Recovery classify(UINT reason) {
+    switch (reason) {
+    case NX_AZURE_IOT_SAS_TOKEN_EXPIRED:
+        return RECOVERY_IMMEDIATE;
+    case NXD_MQTT_ERROR_BAD_USERNAME_PASSWORD:
+    case NXD_MQTT_ERROR_NOT_AUTHORIZED:
+        return RECOVERY_SYNC; // the device may have been moved to a different IoTHub
+    default:
+        return RECOVERY_RECONNECT;
+    }
+}
+
+// Random between the initial delay and an upper limit that doubles with each attempt
+static ULONG backoff_delay_ms(UINT attempt) {
+    const UINT shift = attempt < 16 ? attempt + 1 : 17;
+    ULONG64 limit = (ULONG64) config.initial_delay_ms << shift;
+    if (limit > config.max_delay_ms) {
+        limit = config.max_delay_ms;
+    }
+    if (limit <= config.initial_delay_ms) {
+        return (ULONG) limit;
+    }
+    // RAND_MAX can be as low as 32767, which is not enough for delays of several minutes
+    const ULONG random = ((ULONG) rand() << 15) ^ (ULONG) rand();
+    return config.initial_delay_ms + (ULONG) (random % (limit - config.initial_delay_ms + 1));
+}
+
+static void report(IotConnectConnectionStatus status) {
+    if (status_cb) {
+        status_cb(status);
+    }
+}
+
+// Discovery and sync replace the settings that the application and the other SDK threads use, and the IoTHub client
+// has to be created again if it was released. Both run on the application thread, so this waits for
+// iotconnect_sdk_poll() to run the attempt. Returns false if the reconnect was cancelled in the meantime.
+static bool run_attempt_on_app_thread(bool resync, UINT *status) {
+    tx_semaphore_get(&attempt_done_sem, TX_NO_WAIT); // clear a result that arrived after a cancel
+    is_pending_attempt_resync = resync;
+    is_attempt_pending = true;
+    while (TX_SUCCESS != tx_semaphore_get(&attempt_done_sem, ATTEMPT_POLL_TICKS)) {
+        if (is_cancelled) {
+            is_attempt_pending = false;
+            return false;
+        }
+    }
+    *status = pending_attempt_status;
+    return true;
+}
+
+static void run_reconnect(void) {
+    UINT attempt = 0;
+    UINT reason = start_reason;
+    bool needs_sync = RECOVERY_SYNC == classify(reason);
+
+    while (true) {
+        const ULONG delay_ms = (0 == attempt && RECOVERY_IMMEDIATE == classify(reason)) ? 0 : backoff_delay_ms(attempt);
+        state = IOTC_RECONNECT_WAITING;
+        printf("IOTC: Reconnecting in %lu ms...\r\n", delay_ms);
+        // the wait ends early if the reconnect is cancelled
+        if (TX_SUCCESS == tx_semaphore_get(&cancel_sem, delay_ms * TX_TIMER_TICKS_PER_SECOND / 1000)) {
+            break;
+        }
+
+        if (needs_sync) {
+            attempt++;
+            state = IOTC_RECONNECT_SYNCING;
+            report(IOTC_SYNCING);
+            if (!run_attempt_on_app_thread(true, &reason)) {
+                break;
+            }
+        } else {
+            tx_mutex_get(&attempt_mutex, TX_WAIT_FOREVER);
+            if (is_cancelled) {
+                tx_mutex_put(&attempt_mutex);
+                break;
+            }
+            attempt++;
+            state = IOTC_RECONNECT_CONNECTING;
+            reason = iothub_client_reconnect();
+            tx_mutex_put(&attempt_mutex);
+            // the client was released and needs to be created again
+            if (NX_NOT_ENABLED == reason && !run_attempt_on_app_thread(false, &reason)) {
+                break;
+            }
+        }
+
+        if (NX_SUCCESS == reason) {
+            printf("IOTC: Reconnected after %u attempt(s).\r\n", attempt);
+            state = IOTC_RECONNECT_IDLE; // MQTT_CONNECTED is reported by the IoTHub client
+            return;
+        }
+        if (config.max_attempts && attempt >= config.max_attempts) {
+            printf("IOTC: Unable to reconnect after %u attempts. Giving up.\r\n", attempt);
+            state = IOTC_RECONNECT_FAILED;
+            report(MQTT_FAILED);
+            return;
+        }
+        needs_sync = RECOVERY_SYNC == classify(reason)
+                || (config.sync_after_attempts && 0 == attempt % config.sync_after_attempts);
+    }
+    printf("IOTC: Reconnect cancelled.\r\n");
+    state = IOTC_RECONNECT_IDLE;
+}
+
+static void reconnect_thread_entry(ULONG parameter) {
+    (void) parameter;
+    while (true) {
+        tx_semaphore_get(&start_sem, TX_WAIT_FOREVER);
+        run_reconnect();
+    }
+}
+
+static void apply_config(const IotConnectReconnectConfig *c) {
+    memcpy(&config, c, sizeof(config));
+    if (0 == config.initial_delay_ms) {
+        config.initial_delay_ms = IOTC_RECONNECT_DEFAULT_INITIAL_DELAY_MS;
+    }
+    if (0 == config.max_delay_ms) {
+        config.max_delay_ms = IOTC_RECONNECT_DEFAULT_MAX_DELAY_MS;
+    }
+    if (config.max_delay_ms < config.initial_delay_ms) {
+        config.max_delay_ms = config.initial_delay_ms;
+    }
+}
+
+UINT iotc_reconnect_init(const IotConnectReconnectConfig *c) {
+    UINT status;
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (is_initialized) {
+        tx_mutex_get(&attempt_mutex, TX_WAIT_FOREVER);
+        apply_config(c);
+        tx_mutex_put(&attempt_mutex);
+        return NX_SUCCESS;
+    }
+    apply_config(c);
+    if ((status = tx_mutex_create(&attempt_mutex, "IOTC Reconnect", TX_INHERIT))) {
+        printf("IOTC: Failed to create the reconnect mutex: 0x%x\r\n", status);
+        return status;
+    }
+    if ((status = tx_semaphore_create(&start_sem, "IOTC Reconnect Start", 0))) {
+        printf("IOTC: Failed to create the reconnect semaphore: 0x%x\r\n", status);
+        tx_mutex_delete(&attempt_mutex);
+        return status;
+    }
+    if ((status = tx_semaphore_create(&cancel_sem, "IOTC Reconnect Cancel", 0))) {
+        printf("IOTC: Failed to create the reconnect semaphore: 0x%x\r\n", status);
+        tx_semaphore_delete(&start_sem);
+        tx_mutex_delete(&attempt_mutex);
+        return status;
+    }
+    if ((status = tx_semaphore_create(&attempt_done_sem, "IOTC Reconnect Done", 0))) {
+        printf("IOTC: Failed to create the reconnect semaphore: 0x%x\r\n", status);
+        tx_semaphore_delete(&cancel_sem);
+        tx_semaphore_delete(&start_sem);
+        tx_mutex_delete(&attempt_mutex);
+        return status;
+    }
+    if ((status = tx_thread_create(&reconnect_thread, "IOTC Reconnect",
+            reconnect_thread_entry, 0,
+            reconnect_thread_stack, sizeof(reconnect_thread_stack),
+            IOTC_RECONNECT_THREAD_PRIORITY, IOTC_RECONNECT_THREAD_PRIORITY,
+            TX_NO_TIME_SLICE, TX_AUTO_START))) {
+        printf("IOTC: Failed to create the reconnect thread: 0x%x\r\n", status);
+        tx_semaphore_delete(&attempt_done_sem);
+        tx_semaphore_delete(&cancel_sem);
+        tx_semaphore_delete(&start_sem);
+        tx_mutex_delete(&attempt_mutex);
+        return status;
+    }
+    is_initialized = true;
+    return NX_SUCCESS;
+}
+
+bool iotc_reconnect_is_enabled(void) {
+    return is_initialized;
+}
+
+bool iotc_reconnect_start(UINT reason, IotConnectStatusCallback cb) {
+    if (!is_initialized || NX_SUCCESS == reason) {
+        return false; // the disconnect was requested
+    }
+    if (IOTC_RECONNECT_IDLE != state && IOTC_RECONNECT_FAILED != state) {
+        return true; // already reconnecting
+    }
+    status_cb = cb;
+    start_reason = reason;
+    is_cancelled = false;
+    tx_semaphore_get(&cancel_sem, TX_NO_WAIT); // clear a cancel that arrived while idle
+    state = IOTC_RECONNECT_WAITING;
+    tx_semaphore_ceiling_put(&start_sem, 1);
+    return true;
+}
+
+void iotc_reconnect_cancel(void) {
+    if (!is_initialized) {
+        return;
+    }
+    is_cancelled = true;
+    tx_semaphore_ceiling_put(&cancel_sem, 1);
+    // let the attempt in progress complete, so that the caller can safely disconnect
+    tx_mutex_get(&attempt_mutex, TX_WAIT_FOREVER);
+    tx_mutex_put(&attempt_mutex);
+}
+
+bool iotc_reconnect_take_pending_attempt(bool *resync) {
+    if (!is_initialized || !is_attempt_pending) {
+        return false;
+    }
+    is_attempt_pending = false;
+    *resync = is_pending_attempt_resync;
+    return true;
+}
+
+void iotc_reconnect_attempt_done(UINT status) {
+    pending_attempt_status = status;
+    tx_semaphore_ceiling_put(&attempt_done_sem, 1);
+}
+
+IotConnectReconnectState iotc_reconnect_get_state(void) {
+    return state;
+}
+
+#endif // IOTC_ENABLE_RECONNECT
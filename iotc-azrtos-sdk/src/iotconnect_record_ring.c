@@ -0,0 +1,86 @@
+//
+// Copyright: Avnet 2026
+//
+
+#include <string.h>
+#include "iotconnect_record_ring.h"
+
+// every record is prefixed with its aligned size so that we know how far to advance on pop
+#define RECORD_PREFIX_SIZE sizeof(ULONG)
+#define ALIGN_UP(x) (((x) + sizeof(ULONG) - 1) & ~(sizeof(ULONG) - 1))
+
+void iotc_record_ring_init(IotcRecordRing *ring, void *buffer, size_t size) {
+    memset(ring, 0, sizeof(IotcRecordRing));
+    ring->buffer = (UCHAR *) buffer;
+    ring->size = size & ~(sizeof(ULONG) - 1);
+    ring->end = ring->size;
+}
+
+void *iotc_record_ring_push(IotcRecordRing *ring, size_t record_size) {
+    const size_t total = RECORD_PREFIX_SIZE + ALIGN_UP(record_size);
+    size_t offset;
+
+    if (ring->count > 0 && ring->head == ring->tail) {
+        return NULL; // completely full
+    }
+    if (ring->tail >= ring->head) {
+        // data (if any) is in one contiguous block [head, tail)
+        if (ring->size - ring->tail >= total) {
+            offset = ring->tail;
+        } else if (ring->head >= total) {
+            // wrap around and mark where the data in the top part ends
+            ring->end = ring->tail;
+            offset = 0;
+        } else {
+            return NULL;
+        }
+    } else {
+        // wrapped. Free space is [tail, head)
+        if (ring->head - ring->tail >= total) {
+            offset = ring->tail;
+        } else {
+            return NULL;
+        }
+    }
+    *((ULONG *) &ring->buffer[offset]) = (ULONG) total;
+    ring->tail = offset + total;
+    ring->count++;
+    return &ring->buffer[offset + RECORD_PREFIX_SIZE];
+}
+
+void *iotc_record_ring_peek(IotcRecordRing *ring, size_t *record_size) {
+    if (0 == ring->count) {
+        return NULL;
+    }
+    if (record_size) {
+        *record_size = *((ULONG *) &ring->buffer[ring->head]) - RECORD_PREFIX_SIZE;
+    }
+    return &ring->buffer[ring->head + RECORD_PREFIX_SIZE];
+}
+
+void iotc_record_ring_pop(IotcRecordRing *ring) {
+    if (0 == ring->count) {
+        return;
+    }
+    ring->head += *((ULONG *) &ring->buffer[ring->head]);
+    ring->count--;
+    if (0 == ring->count) {
+        ring->head = 0;
+        ring->tail = 0;
+        ring->end = ring->size;
+    } else if (ring->head >= ring->end) {
+        ring->head = 0;
+        ring->end = ring->size;
+    }
+}
+
+size_t iotc_record_ring_used(IotcRecordRing *ring) {
+    if (0 == ring->count) {
+        return 0;
+    }
+    if (ring->tail > ring->head) {
+        return ring->tail - ring->head;
+    }
+    // wrapped, or completely full
+    return ring->end - ring->head + ring->tail;
+}
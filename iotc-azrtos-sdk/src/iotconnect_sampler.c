@@ -0,0 +1,282 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_SAMPLER
+
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "iotconnect_sampler.h"
+
+// Number of samples. Must be a power of 2.
+#ifndef IOTC_SAMPLER_RING_SIZE
+#define IOTC_SAMPLER_RING_SIZE (64)
+#endif
+
+#ifndef IOTC_SAMPLER_STACK_SIZE
+#define IOTC_SAMPLER_STACK_SIZE (1024)
+#endif
+
+// Higher than the network threads, so that the sampling is not delayed by sending
+#ifndef IOTC_SAMPLER_THREAD_PRIORITY
+#define IOTC_SAMPLER_THREAD_PRIORITY (3)
+#endif
+
+// Longest attribute name written for a channel stat, like "x_stddev"
+#define MAX_KEY_LEN (47)
+
+// Orders the ring slot accesses against the index updates. The default is a ThreadX interrupt posture change,
+// which is a full compiler barrier on every toolchain and sufficient on single core targets.
+// A port can define a cheaper one, like __sync_synchronize() with GCC.
+#ifndef IOTC_SAMPLER_MEMORY_BARRIER
+#define IOTC_SAMPLER_MEMORY_BARRIER() ((void) tx_interrupt_control(tx_interrupt_control(TX_INT_DISABLE)))
+#endif
+
+#if (IOTC_SAMPLER_RING_SIZE & (IOTC_SAMPLER_RING_SIZE - 1)) != 0
+#error "IOTC_SAMPLER_RING_SIZE must be a power of 2"
+#endif
+
+typedef struct {
+    ULONG ticks;
+    float values[IOTC_SAMPLER_MAX_CHANNELS];
+} Sample;
+
+// Running stats using Welford's algorithm, so that the variance is stable without keeping the samples
+typedef struct {
+    ULONG count;
+    double min;
+    double max;
+    double mean;
+    double m2;
+} Accumulator;
+
+// The sampler thread is the only writer of ring_head and the consumer is the only writer of ring_tail.
+static Sample ring[IOTC_SAMPLER_RING_SIZE];
+static volatile ULONG ring_head = 0;
+static volatile ULONG ring_tail = 0;
+static volatile ULONG dropped_count = 0;
+
+static ULONG sampler_thread_stack[IOTC_SAMPLER_STACK_SIZE / sizeof(ULONG)];
+static TX_THREAD sampler_thread;
+static volatile bool is_running = false;
+static IotcSamplerConfig config;
+
+// consumer state
+static Accumulator accumulators[IOTC_SAMPLER_MAX_CHANNELS];
+static IotcSamplerStats window_stats[IOTC_SAMPLER_MAX_CHANNELS];
+static ULONG window_start_ticks;
+static bool has_window_start = false;
+static bool has_window_stats = false;
+
+static void sampler_thread_entry(ULONG parameter) {
+    ULONG sample_number = 0;
+    const ULONG start = tx_time_get();
+    (void) parameter;
+
+    while (is_running) {
+        const ULONG head = ring_head;
+        if (head - ring_tail >= IOTC_SAMPLER_RING_SIZE) {
+            dropped_count++; // rather lose a sample than block or overwrite what the consumer is reading
+        } else {
+            Sample *s = &ring[head & (IOTC_SAMPLER_RING_SIZE - 1)];
+            s->ticks = tx_time_get();
+            if (config.read_cb(config.cb_context, s->values)) {
+                IOTC_SAMPLER_MEMORY_BARRIER(); // the sample must be complete before the consumer can see it
+                ring_head = head + 1;
+            }
+        }
+
+        // schedule against the start time, so that the rate does not drift with the read time
+        sample_number++;
+        const ULONG next = start + (ULONG) ((ULONG64) sample_number * TX_TIMER_TICKS_PER_SECOND / config.rate_hz);
+        const ULONG now = tx_time_get();
+        if ((LONG) (next - now) > 0) {
+            tx_thread_sleep(next - now);
+        } else {
+            tx_thread_relinquish();
+        }
+    }
+}
+
+static void reset_accumulators(void) {
+    memset(accumulators, 0, sizeof(accumulators));
+}
+
+static void accumulate(const Sample *s) {
+    for (UINT i = 0; i < config.channel_count; i++) {
+        Accumulator *a = &accumulators[i];
+        const double value = s->values[i];
+        if (isnan(value)) {
+            continue;
+        }
+        if (0 == a->count || value < a->min) {
+            a->min = value;
+        }
+        if (0 == a->count || value > a->max) {
+            a->max = value;
+        }
+        a->count++;
+        const double delta = value - a->mean;
+        a->mean += delta / (double) a->count;
+        a->m2 += delta * (value - a->mean);
+    }
+}
+
+static void complete_window(void) {
+    for (UINT i = 0; i < config.channel_count; i++) {
+        const Accumulator *a = &accumulators[i];
+        IotcSamplerStats *stats = &window_stats[i];
+        stats->count = a->count;
+        stats->min = a->min;
+        stats->max = a->max;
+        stats->mean = a->mean;
+        stats->stddev = a->count > 1 ? sqrt(a->m2 / (double) (a->count - 1)) : 0;
+    }
+    has_window_stats = true;
+    reset_accumulators();
+}
+
+UINT iotc_sampler_start(const IotcSamplerConfig *c) {
+    UINT status;
+    if (!c || !c->read_cb || !c->channel_names || 0 == c->channel_count || 0 == c->rate_hz || 0 == c->window_ms) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (c->channel_count > IOTC_SAMPLER_MAX_CHANNELS) {
+        printf("IOTC: Sampler: More than IOTC_SAMPLER_MAX_CHANNELS channels\r\n");
+        return NX_INVALID_PARAMETERS;
+    }
+    if (c->rate_hz > TX_TIMER_TICKS_PER_SECOND) {
+        printf("IOTC: Sampler: The rate cannot exceed TX_TIMER_TICKS_PER_SECOND\r\n");
+        return NX_INVALID_PARAMETERS;
+    }
+    if (is_running) {
+        return NX_ALREADY_ENABLED;
+    }
+    memcpy(&config, c, sizeof(config));
+    ring_head = 0;
+    ring_tail = 0;
+    dropped_count = 0;
+    has_window_start = false;
+    has_window_stats = false;
+    reset_accumulators();
+
+    is_running = true;
+    if ((status = tx_thread_create(&sampler_thread, "IOTC Sampler",
+            sampler_thread_entry, 0,
+            sampler_thread_stack, sizeof(sampler_thread_stack),
+            IOTC_SAMPLER_THREAD_PRIORITY, IOTC_SAMPLER_THREAD_PRIORITY,
+            TX_NO_TIME_SLICE, TX_AUTO_START))) {
+        printf("IOTC: Failed to create the sampler thread: 0x%x\r\n", status);
+        is_running = false;
+        return status;
+    }
+    return NX_SUCCESS;
+}
+
+void iotc_sampler_stop(void) {
+    if (!is_running) {
+        return;
+    }
+    is_running = false;
+    tx_thread_terminate(&sampler_thread);
+    tx_thread_delete(&sampler_thread);
+}
+
+bool iotc_sampler_poll(void) {
+    const ULONG window_ticks = (ULONG) ((ULONG64) config.window_ms * TX_TIMER_TICKS_PER_SECOND / 1000);
+    while (ring_tail != ring_head) {
+        IOTC_SAMPLER_MEMORY_BARRIER(); // read the sample only after seeing the head that published it
+        const Sample *s = &ring[ring_tail & (IOTC_SAMPLER_RING_SIZE - 1)];
+        bool is_complete = false;
+        if (!has_window_start) {
+            window_start_ticks = s->ticks;
+            has_window_start = true;
+        } else if (s->ticks - window_start_ticks >= window_ticks) {
+            complete_window();
+            window_start_ticks += window_ticks * ((s->ticks - window_start_ticks) / window_ticks);
+            is_complete = true;
+        }
+        accumulate(s);
+        IOTC_SAMPLER_MEMORY_BARRIER(); // done reading the slot before handing it back to the sampler
+        ring_tail = ring_tail + 1;
+        if (is_complete) {
+            return true; // leave the rest for the next window
+        }
+    }
+    return false;
+}
+
+const IotcSamplerStats *iotc_sampler_get_stats(UINT channel) {
+    if (!has_window_stats || channel >= config.channel_count) {
+        return NULL;
+    }
+    return &window_stats[channel];
+}
+
+// Splits "parent.child" at the first dot, same as the IoTConnect Lib. Sets *parent_len to 0 if there is no parent.
+static const char *split_name(const char *name, size_t *parent_len) {
+    const char *dot = strchr(name, '.');
+    if (!dot) {
+        *parent_len = 0;
+        return name;
+    }
+    *parent_len = (size_t) (dot - name);
+    return dot + 1;
+}
+
+static void write_stat(IotcJsonWriter *w, const char *child, const char *stat, double value) {
+    char key[MAX_KEY_LEN + 1];
+    snprintf(key, sizeof(key), "%s_%s", child, stat);
+    iotc_json_set_number(w, key, value);
+}
+
+bool iotc_sampler_write(IotcJsonWriter *w) {
+    const char *open_parent = NULL; // the object attribute currently open, if any
+    size_t open_parent_len = 0;
+    if (!has_window_stats) {
+        return true;
+    }
+    for (UINT i = 0; i < config.channel_count; i++) {
+        const char *name = config.channel_names[i];
+        size_t parent_len;
+        const char *child = split_name(name, &parent_len);
+
+        // Keep the object that this channel shares with the previous one (like "accelerometer")
+        if (open_parent && (parent_len != open_parent_len || 0 != memcmp(open_parent, name, parent_len))) {
+            iotc_json_object_end(w);
+            open_parent = NULL;
+        }
+        if (parent_len > 0 && !open_parent) {
+            char key[MAX_KEY_LEN + 1];
+            const size_t key_len = parent_len < MAX_KEY_LEN ? parent_len : MAX_KEY_LEN;
+            memcpy(key, name, key_len);
+            key[key_len] = 0;
+            iotc_json_key(w, key);
+            iotc_json_object_begin(w);
+            open_parent = name;
+            open_parent_len = parent_len;
+        }
+
+        const IotcSamplerStats *stats = &window_stats[i];
+        if (stats->count > 0) {
+            write_stat(w, child, "min", stats->min);
+            write_stat(w, child, "max", stats->max);
+            write_stat(w, child, "avg", stats->mean);
+            write_stat(w, child, "stddev", stats->stddev);
+        }
+        write_stat(w, child, "count", (double) stats->count);
+    }
+    if (open_parent) {
+        iotc_json_object_end(w);
+    }
+    return !w->overflow;
+}
+
+ULONG iotc_sampler_dropped_count(void) {
+    return dropped_count;
+}
+
+#endif // IOTC_ENABLE_SAMPLER
@@ -0,0 +1,177 @@
+//
+// Copyright: Avnet 2026
+//
+
+#include <string.h>
+#include "iotconnect_lib.h"
+#include "iotconnect_lib_config.h"
+#include "azrtos_time.h"
+#include "iotconnect_schema.h"
+
+#define SCHEMA_MESSAGE_TIME_SUFFIX "\",\"d\":["
+#define SCHEMA_RECORD_TIME_SUFFIX "\",\"d\":{"
+
+static bool is_same_parent(const IotcSchemaField *a, const IotcSchemaField *b) {
+    if (!a || !b || !a->parent_quoted_key || !b->parent_quoted_key) {
+        return false;
+    }
+    return a->parent_quoted_key_len == b->parent_quoted_key_len
+            && 0 == memcmp(a->parent_quoted_key, b->parent_quoted_key, a->parent_quoted_key_len);
+}
+
+static bool is_envelope_current(const IotcSchemaEnvelope *e, const IotclConfig *lc) {
+    if (!e->is_valid || e->cpid != lc->device.cpid || e->duid != lc->device.duid || e->env != lc->device.env) {
+        return false;
+    }
+    const char *dtg = lc->telemetry.dtg ? lc->telemetry.dtg : "";
+    return 0 == strncmp(&e->message_prefix[e->dtg_offset], dtg, e->dtg_len) && 0 == dtg[e->dtg_len];
+}
+
+// Renders the envelope with the same writer calls as iotc_json_telemetry_begin() and record_begin()
+static bool envelope_render(IotcSchemaEnvelope *e, const IotclConfig *lc) {
+    IotcJsonWriter ew;
+    e->is_valid = false;
+
+    iotc_json_init_buffer(&ew, e->message_prefix, sizeof(e->message_prefix));
+    iotc_json_object_begin(&ew);
+    iotc_json_set_string(&ew, "cpId", lc->device.cpid);
+    iotc_json_key(&ew, "dtg");
+    e->dtg_offset = ew.len + 1; // after the opening quote
+    iotc_json_string(&ew, lc->telemetry.dtg ? lc->telemetry.dtg : "");
+    e->dtg_len = ew.len - 1 - e->dtg_offset;
+    iotc_json_set_number(&ew, "mt", 0);
+    iotc_json_key(&ew, "sdk");
+    iotc_json_object_begin(&ew);
+    iotc_json_set_string(&ew, "l", CONFIG_IOTCONNECT_SDK_NAME);
+    iotc_json_set_string(&ew, "v", CONFIG_IOTCONNECT_SDK_VERSION);
+    iotc_json_set_string(&ew, "e", lc->device.env);
+    iotc_json_object_end(&ew);
+    iotc_json_key(&ew, "t");
+    iotc_json_raw(&ew, "\"", 1);
+    if (ew.overflow) {
+        return false;
+    }
+    e->message_prefix_len = ew.len;
+
+    iotc_json_init_buffer(&ew, e->record_prefix, sizeof(e->record_prefix));
+    iotc_json_object_begin(&ew);
+    iotc_json_set_string(&ew, "id", lc->device.duid);
+    iotc_json_set_string(&ew, "tg", "");
+    iotc_json_key(&ew, "dt");
+    iotc_json_raw(&ew, "\"", 1);
+    if (ew.overflow) {
+        return false;
+    }
+    e->record_prefix_len = ew.len;
+
+    e->cpid = lc->device.cpid;
+    e->duid = lc->device.duid;
+    e->env = lc->device.env;
+    e->is_valid = true;
+    return true;
+}
+
+// Returns NULL if the envelope does not fit into the cache, in which case it needs to be written the regular way
+static const IotcSchemaEnvelope *envelope_get(const IotcSchema *schema) {
+    IotclConfig *lc = iotcl_get_config();
+    IotcSchemaEnvelope *e = schema->envelope;
+    if (!e || !lc) {
+        return NULL;
+    }
+    if (!is_envelope_current(e, lc) && !envelope_render(e, lc)) {
+        return NULL;
+    }
+    return e;
+}
+
+static void write_prefix_with_time(IotcJsonWriter *w, const char *prefix, size_t prefix_len, const char *iso_time,
+        const char *suffix, size_t suffix_len) {
+    char now[UNIX_TIME_ISO_BUFFER_SIZE];
+    if (w->need_comma) {
+        iotc_json_raw(w, ",", 1);
+    }
+    if (!iso_time) {
+        iso_time = unix_time_iso_now(now, sizeof(now));
+    }
+    iotc_json_raw(w, prefix, prefix_len);
+    iotc_json_raw(w, iso_time, strlen(iso_time));
+    iotc_json_raw(w, suffix, suffix_len);
+    w->need_comma = false;
+}
+
+static bool schema_record_begin(IotcJsonWriter *w, const IotcSchema *schema, const char *iso_time) {
+    const IotcSchemaEnvelope *e = envelope_get(schema);
+    if (!e) {
+        return iotc_json_telemetry_record_begin(w, iso_time);
+    }
+    write_prefix_with_time(w, e->record_prefix, e->record_prefix_len, iso_time,
+            SCHEMA_RECORD_TIME_SUFFIX, sizeof(SCHEMA_RECORD_TIME_SUFFIX) - 1);
+    return !w->overflow;
+}
+
+static bool schema_message_begin(IotcJsonWriter *w, const IotcSchema *schema) {
+    const IotcSchemaEnvelope *e = envelope_get(schema);
+    if (!e) {
+        return iotc_json_telemetry_begin(w);
+    }
+    write_prefix_with_time(w, e->message_prefix, e->message_prefix_len, NULL,
+            SCHEMA_MESSAGE_TIME_SUFFIX, sizeof(SCHEMA_MESSAGE_TIME_SUFFIX) - 1);
+    return !w->overflow;
+}
+
+bool iotc_schema_write_record(IotcJsonWriter *w, const IotcSchema *schema, const IotcSchemaValue *values,
+        const char *iso_time) {
+    if (!schema || !values) {
+        return false;
+    }
+    if (!schema_record_begin(w, schema, iso_time)) {
+        return false;
+    }
+    const IotcSchemaField *open_parent = NULL;
+    for (size_t i = 0; i < schema->count; i++) {
+        const IotcSchemaField *f = &schema->fields[i];
+        if (open_parent && !is_same_parent(open_parent, f)) {
+            iotc_json_object_end(w);
+            open_parent = NULL;
+        }
+        if (f->parent_quoted_key && !open_parent) {
+            iotc_json_key_raw(w, f->parent_quoted_key, f->parent_quoted_key_len);
+            iotc_json_object_begin(w);
+            open_parent = f;
+        }
+        iotc_json_key_raw(w, f->quoted_key, f->quoted_key_len);
+        switch (f->type) {
+        case IOTC_SCHEMA_NUMBER:
+            iotc_json_number(w, values[i].number);
+            break;
+        case IOTC_SCHEMA_STRING:
+            if (values[i].string) {
+                iotc_json_string(w, values[i].string);
+            } else {
+                iotc_json_null(w);
+            }
+            break;
+        case IOTC_SCHEMA_BOOL:
+            iotc_json_bool(w, values[i].boolean);
+            break;
+        default:
+            iotc_json_null(w);
+            break;
+        }
+    }
+    if (open_parent) {
+        iotc_json_object_end(w);
+    }
+    return iotc_json_telemetry_record_end(w);
+}
+
+bool iotc_schema_write_message(IotcJsonWriter *w, const IotcSchema *schema, const IotcSchemaValue *values,
+        const char *iso_time) {
+    if (!schema || !schema_message_begin(w, schema)) {
+        return false;
+    }
+    if (!iotc_schema_write_record(w, schema, values, iso_time)) {
+        return false;
+    }
+    return iotc_json_telemetry_end(w);
+}
@@ -0,0 +1,297 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_SEND_QUEUE
+
+#include <string.h>
+#include <stdio.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "azrtos_iothub_client.h"
+#include "iotconnect_record_ring.h"
+#include "iotconnect_rate_limit.h"
+#include "iotconnect_send_queue.h"
+
+#ifndef IOTC_SEND_QUEUE_BUFFER_SIZE
+#define IOTC_SEND_QUEUE_BUFFER_SIZE (4 * 1024)
+#endif
+
+#ifndef IOTC_SEND_QUEUE_CRITICAL_BUFFER_SIZE
+#define IOTC_SEND_QUEUE_CRITICAL_BUFFER_SIZE (1024)
+#endif
+
+// Bulk messages are held back while fewer than this many packets are available in the pool
+#ifndef IOTC_SEND_QUEUE_RESERVED_PACKETS
+#define IOTC_SEND_QUEUE_RESERVED_PACKETS (2)
+#endif
+
+#ifndef IOTC_SEND_QUEUE_STACK_SIZE
+#define IOTC_SEND_QUEUE_STACK_SIZE (4096)
+#endif
+
+#ifndef IOTC_SEND_QUEUE_THREAD_PRIORITY
+#define IOTC_SEND_QUEUE_THREAD_PRIORITY (5)
+#endif
+
+// How long to wait before checking again whether we are connected
+#ifndef IOTC_SEND_QUEUE_RETRY_TICKS
+#define IOTC_SEND_QUEUE_RETRY_TICKS (NX_IP_PERIODIC_RATE)
+#endif
+
+// How long to wait before checking the packet pool again while bulk messages are held back
+#ifndef IOTC_SEND_QUEUE_POOL_RETRY_TICKS
+#define IOTC_SEND_QUEUE_POOL_RETRY_TICKS (NX_IP_PERIODIC_RATE / 10)
+#endif
+
+// Set when a critical entry is queued, so that the publisher stops waiting to send a bulk entry
+#define CRITICAL_QUEUED_EVENT (1UL)
+
+typedef struct {
+    IotConnectSendCallback cb;
+    void *cb_context;
+    const IotConnectMessageProperties *properties;
+    size_t data_len;
+    UCHAR data[];
+} QueueEntry;
+
+static ULONG queue_buffer[IOTC_SEND_QUEUE_BUFFER_SIZE / sizeof(ULONG)];
+static ULONG critical_queue_buffer[IOTC_SEND_QUEUE_CRITICAL_BUFFER_SIZE / sizeof(ULONG)];
+static ULONG publisher_thread_stack[IOTC_SEND_QUEUE_STACK_SIZE / sizeof(ULONG)];
+static TX_THREAD publisher_thread;
+static TX_MUTEX queue_mutex;
+static TX_MUTEX send_lock;
+static TX_SEMAPHORE pending_sem;
+static TX_EVENT_FLAGS_GROUP critical_events;
+static IotcRecordRing bulk_ring;
+static IotcRecordRing critical_ring;
+static bool is_initialized = false;
+
+// The entry that the publisher is currently sending. It must not be dropped on overflow.
+static QueueEntry *in_flight_entry = NULL;
+
+// Picks the next entry to send, leaves it at the head of its ring and marks it as in flight.
+// Returns NULL if the queue is empty, or if a bulk entry has to wait, in which case wait_ticks is set.
+static QueueEntry *take_next_entry(IotcRecordRing **lane, ULONG *wait_ticks) {
+    *wait_ticks = 0;
+    tx_mutex_get(&queue_mutex, TX_WAIT_FOREVER);
+    *lane = (iotc_record_ring_count(&critical_ring) > 0) ? &critical_ring : &bulk_ring;
+    QueueEntry *entry = (QueueEntry *) iotc_record_ring_peek(*lane, NULL);
+    if (entry && &critical_ring == *lane) {
+#ifdef IOTC_ENABLE_RATE_LIMIT
+        // take the tokens if available, so that the bulk traffic backs off, but never hold back
+        iotc_rate_limit_try_acquire(entry->data_len, wait_ticks);
+        *wait_ticks = 0;
+#endif
+    } else if (entry) {
+        // Bulk entries wait while the packet pool is low. The tokens are taken last,
+        // so that they are not spent while the entry is held back for another reason.
+        if (!iothub_client_is_connected()) {
+            *wait_ticks = IOTC_SEND_QUEUE_RETRY_TICKS;
+        } else if (iothub_client_available_packets() < IOTC_SEND_QUEUE_RESERVED_PACKETS) {
+            *wait_ticks = (IOTC_SEND_QUEUE_POOL_RETRY_TICKS > 0) ? IOTC_SEND_QUEUE_POOL_RETRY_TICKS : 1;
+        }
+#ifdef IOTC_ENABLE_RATE_LIMIT
+        else {
+            iotc_rate_limit_try_acquire(entry->data_len, wait_ticks);
+        }
+#endif
+        if (*wait_ticks > 0) {
+            entry = NULL;
+        }
+    }
+    in_flight_entry = entry;
+    tx_mutex_put(&queue_mutex);
+    return entry;
+}
+
+// Returns NX_NOT_CONNECTED if a bulk entry could not be sent because we got disconnected in the meantime
+static UINT send_entry(IotcRecordRing *lane, QueueEntry *entry) {
+    UINT status;
+    while (true) {
+        tx_mutex_get(&send_lock, TX_WAIT_FOREVER);
+        if (iothub_client_is_connected()) {
+            status = iothub_send_message_n(entry->data, entry->data_len, entry->properties);
+            tx_mutex_put(&send_lock);
+            return status;
+        }
+        tx_mutex_put(&send_lock);
+        if (&critical_ring != lane) {
+            return NX_NOT_CONNECTED;
+        }
+        tx_thread_sleep(IOTC_SEND_QUEUE_RETRY_TICKS);
+    }
+}
+
+static void publisher_thread_entry(ULONG parameter) {
+    (void) parameter; // unused
+    while (true) {
+        // One count per enqueued entry. Entries dropped on overflow leave their count behind.
+        tx_semaphore_get(&pending_sem, TX_WAIT_FOREVER);
+
+        // The entry stays at the head of the ring until it is sent, so the producers will never overwrite it
+        IotcRecordRing *lane;
+        QueueEntry *entry;
+        ULONG wait_ticks;
+        UINT status = NX_SUCCESS;
+        while (true) {
+            entry = take_next_entry(&lane, &wait_ticks);
+            if (!entry) {
+                if (0 == wait_ticks) {
+                    break; // nothing left to send
+                }
+                // A critical entry queued in the meantime ends the wait, so that it does not wait behind the bulk one
+                ULONG actual_events;
+                tx_event_flags_get(&critical_events, CRITICAL_QUEUED_EVENT, TX_OR_CLEAR, &actual_events, wait_ticks);
+                continue; // the head may have changed in the meantime
+            }
+            if (NX_NOT_CONNECTED != (status = send_entry(lane, entry))) {
+                break;
+            }
+            tx_mutex_get(&queue_mutex, TX_WAIT_FOREVER);
+            in_flight_entry = NULL;
+            tx_mutex_put(&queue_mutex);
+        }
+        if (!entry) {
+            continue;
+        }
+
+        IotConnectSendCallback cb = entry->cb;
+        void *cb_context = entry->cb_context;
+
+        tx_mutex_get(&queue_mutex, TX_WAIT_FOREVER);
+        iotc_record_ring_pop(lane);
+        in_flight_entry = NULL;
+        tx_mutex_put(&queue_mutex);
+
+        if (status) {
+            printf("IOTC: Queued message send failed with error 0x%x\r\n", status);
+        }
+        if (cb) {
+            cb(cb_context, status);
+        }
+    }
+}
+
+#ifdef IOTC_ENABLE_RATE_LIMIT
+// Drops the oldest bulk entry to make room. Must be called with the mutex held.
+// The callback of the dropped entry is returned, so that it can be called once the mutex is released.
+// Returns false if there is nothing that can be dropped.
+static bool drop_oldest_locked(IotConnectSendCallback *cb, void **cb_context) {
+    QueueEntry *entry = (QueueEntry *) iotc_record_ring_peek(&bulk_ring, NULL);
+    if (!entry || entry == in_flight_entry) {
+        return false;
+    }
+    printf("IOTC: Rate limit exceeded. Dropping the oldest queued message.\r\n");
+    *cb = entry->cb;
+    *cb_context = entry->cb_context;
+    iotc_record_ring_pop(&bulk_ring);
+    return true;
+}
+#endif
+
+UINT iotc_send_queue_init(void) {
+    UINT status;
+    if (is_initialized) {
+        return NX_SUCCESS;
+    }
+    iotc_record_ring_init(&bulk_ring, queue_buffer, sizeof(queue_buffer));
+    iotc_record_ring_init(&critical_ring, critical_queue_buffer, sizeof(critical_queue_buffer));
+
+    if ((status = tx_mutex_create(&queue_mutex, "IOTC Send Queue", TX_NO_INHERIT))) {
+        printf("IOTC: Failed to create the send queue mutex: 0x%x\r\n", status);
+        return status;
+    }
+    if ((status = tx_mutex_create(&send_lock, "IOTC Send Lock", TX_INHERIT))) {
+        printf("IOTC: Failed to create the send lock: 0x%x\r\n", status);
+        tx_mutex_delete(&queue_mutex);
+        return status;
+    }
+    if ((status = tx_semaphore_create(&pending_sem, "IOTC Send Pending", 0))) {
+        printf("IOTC: Failed to create the send queue semaphore: 0x%x\r\n", status);
+        tx_mutex_delete(&send_lock);
+        tx_mutex_delete(&queue_mutex);
+        return status;
+    }
+    if ((status = tx_event_flags_create(&critical_events, "IOTC Send Critical"))) {
+        printf("IOTC: Failed to create the send queue event flags: 0x%x\r\n", status);
+        tx_semaphore_delete(&pending_sem);
+        tx_mutex_delete(&send_lock);
+        tx_mutex_delete(&queue_mutex);
+        return status;
+    }
+    if ((status = tx_thread_create(&publisher_thread, "IOTC Publisher",
+            publisher_thread_entry, 0,
+            publisher_thread_stack, sizeof(publisher_thread_stack),
+            IOTC_SEND_QUEUE_THREAD_PRIORITY, IOTC_SEND_QUEUE_THREAD_PRIORITY,
+            TX_NO_TIME_SLICE, TX_AUTO_START))) {
+        printf("IOTC: Failed to create the publisher thread: 0x%x\r\n", status);
+        tx_event_flags_delete(&critical_events);
+        tx_semaphore_delete(&pending_sem);
+        tx_mutex_delete(&send_lock);
+        tx_mutex_delete(&queue_mutex);
+        return status;
+    }
+    is_initialized = true;
+    return NX_SUCCESS;
+}
+
+UINT iotc_send_queue_enqueue(const void *data, size_t data_len, const IotConnectMessageProperties *properties,
+        IotConnectSendPriority priority, IotConnectSendCallback cb, void *cb_context) {
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
+    if (!data || 0 == data_len) {
+        return NX_INVALID_PARAMETERS;
+    }
+
+    IotcRecordRing *lane = (IOTC_PRIORITY_CRITICAL == priority) ? &critical_ring : &bulk_ring;
+    QueueEntry *entry;
+    while (true) {
+        tx_mutex_get(&queue_mutex, TX_WAIT_FOREVER);
+        if (NULL != (entry = (QueueEntry *) iotc_record_ring_push(lane, sizeof(QueueEntry) + data_len))) {
+            break; // filled in below, with the mutex held
+        }
+#ifdef IOTC_ENABLE_RATE_LIMIT
+        IotConnectSendCallback dropped_cb = NULL;
+        void *dropped_cb_context = NULL;
+        if (&bulk_ring == lane && IOTC_RATE_LIMIT_DROP_OLDEST == iotc_rate_limit_get_policy()
+                && drop_oldest_locked(&dropped_cb, &dropped_cb_context)) {
+            tx_mutex_put(&queue_mutex);
+            // Not holding the mutex, so that the callback does not stall the publisher and may queue again
+            if (dropped_cb) {
+                dropped_cb(dropped_cb_context, NX_NO_MORE_ENTRIES);
+            }
+            continue;
+        }
+#endif
+        tx_mutex_put(&queue_mutex);
+        return NX_OVERFLOW;
+    }
+    entry->cb = cb;
+    entry->cb_context = cb_context;
+    entry->properties = properties;
+    entry->data_len = data_len;
+    memcpy(entry->data, data, data_len);
+    tx_mutex_put(&queue_mutex);
+
+    tx_semaphore_put(&pending_sem);
+    if (IOTC_PRIORITY_CRITICAL == priority) {
+        tx_event_flags_set(&critical_events, CRITICAL_QUEUED_EVENT, TX_OR);
+    }
+    return NX_SUCCESS;
+}
+
+void iotc_send_queue_lock(void) {
+    if (is_initialized) {
+        tx_mutex_get(&send_lock, TX_WAIT_FOREVER);
+    }
+}
+
+void iotc_send_queue_unlock(void) {
+    if (is_initialized) {
+        tx_mutex_put(&send_lock);
+    }
+}
+
+#endif // IOTC_ENABLE_SEND_QUEUE
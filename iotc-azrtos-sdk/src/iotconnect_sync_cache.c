@@ -0,0 +1,236 @@
+//
+// Copyright: Avnet 2026
+//
+
+#ifdef IOTC_ENABLE_SYNC_CACHE
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "azrtos_time.h"
+#include "iotconnect_sync_cache.h"
+
+#ifndef IOTC_SYNC_CACHE_MAX_SIZE
+#define IOTC_SYNC_CACHE_MAX_SIZE (512)
+#endif
+
+#ifndef IOTC_SYNC_CACHE_DEFAULT_MAX_AGE_S
+#define IOTC_SYNC_CACHE_DEFAULT_MAX_AGE_S (7 * 24 * 60 * 60)
+#endif
+
+#ifndef IOTC_SYNC_CACHE_DEFAULT_FILE_NAME
+#define IOTC_SYNC_CACHE_DEFAULT_FILE_NAME "iotc_sync.bin"
+#endif
+
+#define CACHE_MAGIC (0x31435349) // "ISC1"
+
+// cpid, env, duid, host, client_id, dtg. Each one null terminated.
+#define CACHE_STRING_COUNT (6)
+
+typedef struct {
+    ULONG magic;
+    ULONG saved_time;   // unix time
+    ULONG strings_len;
+    ULONG checksum;     // of the strings
+} CacheHeader;
+
+// The loaded entry points into cache_buffer and the IoTHub client may still use it, so the saved cache
+// is built in a buffer of its own
+static ULONG cache_buffer[IOTC_SYNC_CACHE_MAX_SIZE / sizeof(ULONG)];
+static ULONG save_buffer[IOTC_SYNC_CACHE_MAX_SIZE / sizeof(ULONG)];
+static IotConnectSyncCacheConfig config = { 0 };
+static bool is_initialized = false;
+
+static CacheHeader *cache_header(ULONG *buffer) {
+    return (CacheHeader *) buffer;
+}
+
+static char *cache_strings(ULONG *buffer) {
+    return (char *) buffer + sizeof(CacheHeader);
+}
+
+// FNV-1a, to detect a cache that was only partially written
+static ULONG checksum(const char *data, ULONG len) {
+    uint32_t hash = 2166136261U;
+    for (ULONG i = 0; i < len; i++) {
+        hash ^= (UCHAR) data[i];
+        hash *= 16777619U;
+    }
+    return (ULONG) hash;
+}
+
+#ifdef IOTC_ENABLE_SYNC_CACHE_FILEX
+static CHAR *file_name(void) {
+    return config.file_name ? config.file_name : IOTC_SYNC_CACHE_DEFAULT_FILE_NAME;
+}
+
+static UINT file_read(void *buffer, ULONG buffer_size, ULONG *len) {
+    FX_FILE file;
+    UINT status;
+    if ((status = fx_file_open(config.media, &file, file_name(), FX_OPEN_FOR_READ))) {
+        return status;
+    }
+    status = fx_file_read(&file, buffer, buffer_size, len);
+    fx_file_close(&file);
+    return status;
+}
+
+static UINT file_write(const void *data, ULONG len) {
+    FX_FILE file;
+    UINT status = fx_file_delete(config.media, file_name());
+    if (status && FX_NOT_FOUND != status) {
+        printf("IOTC: Sync cache: Failed to delete %s. Error: 0x%x\r\n", file_name(), status);
+        return status;
+    }
+    if (len > 0) {
+        if ((status = fx_file_create(config.media, file_name()))) {
+            printf("IOTC: Sync cache: Failed to create %s. Error: 0x%x\r\n", file_name(), status);
+            return status;
+        }
+        if ((status = fx_file_open(config.media, &file, file_name(), FX_OPEN_FOR_WRITE))) {
+            printf("IOTC: Sync cache: Failed to open %s. Error: 0x%x\r\n", file_name(), status);
+            return status;
+        }
+        status = fx_file_write(&file, (VOID *) data, len);
+        fx_file_close(&file);
+        if (status) {
+            printf("IOTC: Sync cache: Failed to write %s. Error: 0x%x\r\n", file_name(), status);
+            return status;
+        }
+    }
+    return fx_media_flush(config.media);
+}
+#endif // IOTC_ENABLE_SYNC_CACHE_FILEX
+
+static UINT storage_read(void *buffer, ULONG buffer_size, ULONG *len) {
+#ifdef IOTC_ENABLE_SYNC_CACHE_FILEX
+    if (config.media) {
+        return file_read(buffer, buffer_size, len);
+    }
+#endif
+    return config.read_cb(config.cb_context, buffer, buffer_size, len);
+}
+
+static UINT storage_write(const void *data, ULONG len) {
+#ifdef IOTC_ENABLE_SYNC_CACHE_FILEX
+    if (config.media) {
+        return file_write(data, len);
+    }
+#endif
+    return config.write_cb(config.cb_context, data, len);
+}
+
+UINT iotc_sync_cache_init(const IotConnectSyncCacheConfig *c) {
+    if (!c) {
+        return NX_INVALID_PARAMETERS;
+    }
+    bool has_storage = c->read_cb && c->write_cb;
+#ifdef IOTC_ENABLE_SYNC_CACHE_FILEX
+    has_storage = has_storage || c->media;
+#endif
+    if (!has_storage) {
+        printf("IOTC: Sync cache: No storage is configured\r\n");
+        return NX_INVALID_PARAMETERS;
+    }
+    memcpy(&config, c, sizeof(config));
+    if (0 == config.max_age_s) {
+        config.max_age_s = IOTC_SYNC_CACHE_DEFAULT_MAX_AGE_S;
+    }
+    is_initialized = true;
+    return NX_SUCCESS;
+}
+
+bool iotc_sync_cache_is_enabled(void) {
+    return is_initialized;
+}
+
+UINT iotc_sync_cache_load(const char *cpid, const char *env, const char *duid, IotConnectSyncCacheEntry *entry) {
+    const char *expected[3] = { cpid ? cpid : "", env ? env : "", duid ? duid : "" };
+    const char *strings[CACHE_STRING_COUNT];
+    CacheHeader *header = cache_header(cache_buffer);
+    ULONG len = 0;
+    ULONG now;
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
+    if (!entry) {
+        return NX_INVALID_PARAMETERS;
+    }
+    if (storage_read(cache_buffer, sizeof(cache_buffer), &len)
+            || len < sizeof(CacheHeader)
+            || CACHE_MAGIC != header->magic
+            || header->strings_len != len - sizeof(CacheHeader)
+            || header->checksum != checksum(cache_strings(cache_buffer), header->strings_len)) {
+        return NX_NOT_FOUND;
+    }
+
+    const char *p = cache_strings(cache_buffer);
+    const char *end = p + header->strings_len;
+    for (int i = 0; i < CACHE_STRING_COUNT; i++) {
+        const char *terminator = memchr(p, 0, (size_t) (end - p));
+        if (!terminator) {
+            return NX_NOT_FOUND;
+        }
+        strings[i] = p;
+        p = terminator + 1;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (0 != strcmp(strings[i], expected[i])) {
+            printf("IOTC: Sync cache: Saved for a different device\r\n");
+            return NX_NOT_FOUND;
+        }
+    }
+    // also stale if the clock went backwards, or is not set yet
+    unix_time_get(&now);
+    if (now < header->saved_time || now - header->saved_time > config.max_age_s) {
+        printf("IOTC: Sync cache: Expired\r\n");
+        return NX_NOT_FOUND;
+    }
+    entry->host = strings[3];
+    entry->client_id = strings[4];
+    entry->dtg = strings[5];
+    return NX_SUCCESS;
+}
+
+UINT iotc_sync_cache_save(const char *cpid, const char *env, const char *duid, const IotConnectSyncCacheEntry *entry) {
+    CacheHeader *header = cache_header(save_buffer);
+    char *p = cache_strings(save_buffer);
+    const char *end = (char *) save_buffer + sizeof(save_buffer);
+    UINT status;
+    if (!is_initialized) {
+        return NX_NOT_ENABLED;
+    }
+    if (!entry || !entry->host || !entry->client_id || !entry->dtg) {
+        return NX_INVALID_PARAMETERS;
+    }
+    const char *strings[CACHE_STRING_COUNT] = {
+            cpid ? cpid : "", env ? env : "", duid ? duid : "", entry->host, entry->client_id, entry->dtg
+    };
+    for (int i = 0; i < CACHE_STRING_COUNT; i++) {
+        const size_t len = strlen(strings[i]) + 1;
+        if (len > (size_t) (end - p)) {
+            printf("IOTC: Sync cache: The settings exceed IOTC_SYNC_CACHE_MAX_SIZE\r\n");
+            return NX_SIZE_ERROR;
+        }
+        memcpy(p, strings[i], len);
+        p += len;
+    }
+    header->magic = CACHE_MAGIC;
+    unix_time_get(&header->saved_time);
+    header->strings_len = (ULONG) (p - cache_strings(save_buffer));
+    header->checksum = checksum(cache_strings(save_buffer), header->strings_len);
+    if ((status = storage_write(save_buffer, sizeof(CacheHeader) + header->strings_len))) {
+        printf("IOTC: Sync cache: Failed to save. Error: 0x%x\r\n", status);
+    }
+    return status;
+}
+
+void iotc_sync_cache_invalidate(void) {
+    if (is_initialized) {
+        storage_write(save_buffer, 0);
+    }
+}
+
+#endif // IOTC_ENABLE_SYNC_CACHE
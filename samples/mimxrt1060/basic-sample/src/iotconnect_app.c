@@ -9,6 +9,7 @@
 #include "nxd_dns.h"
 #include "iotconnect_common.h"
 #include "iotconnect.h"
+#include "azrtos_time.h"
 #include "iotc_auth_driver.h"
 #include "sw_auth_driver.h"
 
@@ -163,7 +164,8 @@ static void publish_telemetry() {
 
     // Optional. The first time you create a data point, the current timestamp will be automatically added
     // TelemetryAddWith* calls are only required if sending multiple data points in one packet.
-    iotcl_telemetry_add_with_iso_time(msg, iotcl_iso_timestamp_now());
+    char timestamp[UNIX_TIME_ISO_BUFFER_SIZE];
+    iotcl_telemetry_add_with_iso_time(msg, unix_time_iso_now(timestamp, sizeof(timestamp)));
     iotcl_telemetry_set_string(msg, "version", APP_VERSION);
     iotcl_telemetry_set_number(msg, "cpu", 3.123); // test floating point numbers
 
@@ -28,10 +28,19 @@
 #endif
 
 #include "iotconnect.h"
+#ifdef IOTC_ENABLE_SAMPLER
+#include "iotconnect_sampler.h"
+#endif
 
 int init_sensors(void);
 void sensors_add_telemetry(IotclMessageHandle msg);
 
+#ifdef IOTC_ENABLE_SAMPLER
+// Samples the accelerometer and gyroscope from a dedicated thread.
+// sensors_add_telemetry() then reports their stats over the last window instead of a single reading.
+UINT sensors_start_motion_sampling(UINT rate_hz, UINT window_ms);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
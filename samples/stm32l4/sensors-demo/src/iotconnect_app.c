@@ -9,12 +9,14 @@
 #include "nxd_dns.h"
 #include "iotconnect_common.h"
 #include "iotconnect.h"
+#include "azrtos_time.h"
 #include "iotconnect_certs.h"
 #include "azrtos_ota_fw_client.h"
 #include "azrtos_adu_agent.h"
 #include "iotc_auth_driver.h"
 #include "sw_auth_driver.h"
 #include "sensors_data.h"
+#include "iotconnect_reconnect.h"
 
 // from nx_azure_iot_adu_agent_<boardname>_driver.c
 extern void nx_azure_iot_adu_agent_driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr);
@@ -24,6 +26,9 @@ static IotcAuthInterfaceContext auth_driver_context;
 
 #define APP_VERSION "1.0.0"
 
+// Reconnect after this long. About 5.5 hours, same as 10000 telemetry messages 2 seconds apart.
+#define SESSION_DURATION_TICKS ((ULONG) (10000ULL * 2 * TX_TIMER_TICKS_PER_SECOND))
+
 //#define MEMORY_TEST
 #ifdef MEMORY_TEST
 #define TEST_BLOCK_SIZE  10 * 1024
@@ -259,12 +264,24 @@ static void on_connection_status(IotConnectConnectionStatus status) {
     case MQTT_DISCONNECTED:
         printf("IoTConnect Client Disconnected\r\n");
         break;
+    case MQTT_RECONNECTING:
+        printf("IoTConnect Client Reconnecting\r\n");
+        return; // the auth driver is needed to reconnect
+    case IOTC_SYNCING:
+        printf("IoTConnect Client Syncing\r\n");
+        return;
     default:
         printf("IoTConnect Client ERROR\r\n");
         break;
     }
+#ifdef IOTC_ENABLE_RECONNECT
+    if (MQTT_CONNECTED == status) {
+        return; // the SDK may need to connect again with it later
+    }
+#endif
     if (NULL != auth_driver_context) {
     	release_sw_der_auth_driver(auth_driver_context);
+    	auth_driver_context = NULL;
     }
 }
 
@@ -273,7 +290,8 @@ static void publish_telemetry() {
 
     // Optional. The first time you create a data point, the current timestamp will be automatically added
     // TelemetryAddWith* calls are only required if sending multiple data points in one packet.
-    iotcl_telemetry_add_with_iso_time(msg, iotcl_iso_timestamp_now());
+    char timestamp[UNIX_TIME_ISO_BUFFER_SIZE];
+    iotcl_telemetry_add_with_iso_time(msg, unix_time_iso_now(timestamp, sizeof(timestamp)));
     iotcl_telemetry_set_string(msg, "version", APP_VERSION);
     iotcl_telemetry_set_number(msg, "cpu", 3.123); // test floating point numbers
 
@@ -331,6 +349,14 @@ bool app_startup(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr) {
 
 #endif  // IOTCONNECT_SYMETRIC_KEY
 
+#ifdef IOTC_ENABLE_RECONNECT
+    // Reconnect with backoff when the connection is lost. Run discovery and sync after 5 failed attempts.
+    static const IotConnectReconnectConfig reconnect_config = { .sync_after_attempts = 5 };
+    if (iotc_reconnect_init(&reconnect_config)) {
+        printf("Failed to initialize the reconnect engine.\r\n");
+    }
+#endif
+
     while (true) {
 #ifdef MEMORY_TEST
         // check for leaks
@@ -350,12 +376,37 @@ bool app_startup(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr) {
             APP_VERSION
             );
 
-        // send telemetry periodically
-        for (int i = 0; i < 10000; i++) {
+#ifdef IOTC_ENABLE_SAMPLER
+        // 100 Hz motion sampling. One message with the stats is sent every 10 second window.
+        static bool is_sampling = false;
+        if (!is_sampling) {
+            is_sampling = !sensors_start_motion_sampling(100, 10000);
+        }
+#endif
+
+        // send telemetry periodically. The session is time based, as the poll interval depends on the configuration.
+        const ULONG session_start = tx_time_get();
+        while (tx_time_get() - session_start < SESSION_DURATION_TICKS) {
             if (iotconnect_sdk_is_connected()) {
+#ifdef IOTC_ENABLE_SAMPLER
+                // poll often enough to keep the sample ring from filling up
+                if (iotc_sampler_poll()) {
+                    publish_telemetry();
+                }
+                iotconnect_sdk_poll(100);
+#else
                 publish_telemetry();  // underlying code will report an error
                 iotconnect_sdk_poll(2000);
+#endif
             } else {
+#ifdef IOTC_ENABLE_RECONNECT
+                const IotConnectReconnectState state = iotc_reconnect_get_state();
+                if (IOTC_RECONNECT_IDLE != state && IOTC_RECONNECT_FAILED != state) {
+                    // the SDK is reconnecting. Discovery and sync, if needed, run from the poll.
+                    iotconnect_sdk_poll(1000);
+                    continue;
+                }
+#endif
                 return false;
             }
         }
@@ -144,9 +144,83 @@ int init_sensors(void)
 
   return ret;
 }
+#ifdef IOTC_ENABLE_SAMPLER
+// The sampler thread and the telemetry thread share the sensor bus
+static TX_MUTEX sensor_bus_mutex;
+#define SENSOR_BUS_LOCK() tx_mutex_get(&sensor_bus_mutex, TX_WAIT_FOREVER)
+#define SENSOR_BUS_UNLOCK() tx_mutex_put(&sensor_bus_mutex)
+
+static const char *motion_channel_names[] = {
+    "accelerometer.x", "accelerometer.y", "accelerometer.z",
+    "gyroscope.x", "gyroscope.y", "gyroscope.z"
+};
+
+static bool read_motion_sample(void *context, float *values) {
+    BSP_MOTION_SENSOR_Axes_t accelerometer = {0};
+    BSP_MOTION_SENSOR_Axes_t gyroscope = {0};
+    SENSOR_BUS_LOCK();
+    int32_t ret = BSP_MOTION_SENSOR_GetAxes(INSTANCE_GYROSCOPE_ACCELEROMETER, MOTION_ACCELERO, &accelerometer);
+    if (ret == BSP_ERROR_NONE) {
+        ret = BSP_MOTION_SENSOR_GetAxes(INSTANCE_GYROSCOPE_ACCELEROMETER, MOTION_GYRO, &gyroscope);
+    }
+    SENSOR_BUS_UNLOCK();
+    if (ret != BSP_ERROR_NONE) {
+        return false;
+    }
+    values[0] = accelerometer.x;
+    values[1] = accelerometer.y;
+    values[2] = accelerometer.z;
+    values[3] = gyroscope.x;
+    values[4] = gyroscope.y;
+    values[5] = gyroscope.z;
+    return true;
+}
+
+UINT sensors_start_motion_sampling(UINT rate_hz, UINT window_ms) {
+    UINT status;
+    IotcSamplerConfig config = {0};
+    if ((status = tx_mutex_create(&sensor_bus_mutex, "Sensor Bus", TX_INHERIT))) {
+        printf("Failed to create the sensor bus mutex: 0x%x\r\n", status);
+        return status;
+    }
+    config.channel_names = motion_channel_names;
+    config.channel_count = sizeof(motion_channel_names) / sizeof(motion_channel_names[0]);
+    config.rate_hz = rate_hz;
+    config.window_ms = window_ms;
+    config.read_cb = read_motion_sample;
+    return iotc_sampler_start(&config);
+}
+
+// "accelerometer.x_min" is sent as {"accelerometer":{"x_min":..}}, same as iotc_sampler_write() would write it
+static void add_motion_stats(IotclMessageHandle msg) {
+    char full_name[40];
+    for (UINT i = 0; i < sizeof(motion_channel_names) / sizeof(motion_channel_names[0]); i++) {
+        const IotcSamplerStats *stats = iotc_sampler_get_stats(i);
+        if (!stats || 0 == stats->count) {
+            continue;
+        }
+        sprintf(full_name, "%s_%s", motion_channel_names[i], "min");
+        iotcl_telemetry_set_number(msg, full_name, stats->min);
+        sprintf(full_name, "%s_%s", motion_channel_names[i], "max");
+        iotcl_telemetry_set_number(msg, full_name, stats->max);
+        sprintf(full_name, "%s_%s", motion_channel_names[i], "avg");
+        iotcl_telemetry_set_number(msg, full_name, stats->mean);
+        sprintf(full_name, "%s_%s", motion_channel_names[i], "stddev");
+        iotcl_telemetry_set_number(msg, full_name, stats->stddev);
+        sprintf(full_name, "%s_%s", motion_channel_names[i], "count");
+        iotcl_telemetry_set_number(msg, full_name, stats->count);
+    }
+}
+#else
+#define SENSOR_BUS_LOCK()
+#define SENSOR_BUS_UNLOCK()
+#endif // IOTC_ENABLE_SAMPLER
+
 static void add_env_sensor_value(IotclMessageHandle msg, const char* name, uint32_t instance, uint32_t function) {
     float_t value = 0;
+    SENSOR_BUS_LOCK();
     uint32_t ret = BSP_ENV_SENSOR_GetValue(instance, function, &value);
+    SENSOR_BUS_UNLOCK();
     if (ret != BSP_ERROR_NONE) {
         printf("Failed to get %s. Error was %lu", name, ret);
     } else {
@@ -155,7 +229,9 @@ static void add_env_sensor_value(IotclMessageHandle msg, const char* name, uint3
 }
 static void add_motion_sensor_value(IotclMessageHandle msg, const char* name, uint32_t instance, uint32_t function) {
     BSP_MOTION_SENSOR_Axes_t value = {0};
+    SENSOR_BUS_LOCK();
     uint32_t ret = BSP_MOTION_SENSOR_GetAxes(instance, function, &value);
+    SENSOR_BUS_UNLOCK();
     if (ret != BSP_ERROR_NONE) {
         printf("Failed to get %s. Error was %lu", name, ret);
     } else {
@@ -174,7 +250,11 @@ void sensors_add_telemetry(IotclMessageHandle msg) {
     add_env_sensor_value(msg, "temperature", INSTANCE_TEMPERATURE_HUMIDITY, ENV_TEMPERATURE);
     add_env_sensor_value(msg, "humidity", INSTANCE_TEMPERATURE_HUMIDITY, ENV_HUMIDITY);
     add_env_sensor_value(msg, "pressure", INSTANCE_TEMPERATURE_PRESSURE, ENV_PRESSURE);
-    add_motion_sensor_value(msg, "gyroscope", INSTANCE_GYROSCOPE_ACCELEROMETER, MOTION_GYRO);
     add_motion_sensor_value(msg, "magnetometer", INSTANCE_MAGNETOMETER, MOTION_MAGNETO);
+#ifdef IOTC_ENABLE_SAMPLER
+    add_motion_stats(msg);
+#else
+    add_motion_sensor_value(msg, "gyroscope", INSTANCE_GYROSCOPE_ACCELEROMETER, MOTION_GYRO);
     add_motion_sensor_value(msg, "accelerometer", INSTANCE_GYROSCOPE_ACCELEROMETER, MOTION_ACCELERO);
+#endif
 }
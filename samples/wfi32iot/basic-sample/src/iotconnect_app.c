@@ -11,6 +11,7 @@
 #include "nxd_dns.h"
 #include "iotconnect_common.h"
 #include "iotconnect.h"
+#include "azrtos_time.h"
 #include "iotc_auth_driver.h"
 #include "sw_auth_driver.h"
 #include "app.h" // original Microchip app include for sensors
@@ -205,7 +206,8 @@ static void publish_telemetry(struct click_board_connections click_board_detecti
     time_t now = time(NULL);
     int running_time = now - start_time;
    
-    iotcl_telemetry_add_with_iso_time(msg, iotcl_iso_timestamp_now());
+    char timestamp[UNIX_TIME_ISO_BUFFER_SIZE];
+    iotcl_telemetry_add_with_iso_time(msg, unix_time_iso_now(timestamp, sizeof(timestamp)));
     iotcl_telemetry_set_string(msg, "version", APP_VERSION);
     
     iotcl_telemetry_set_number(msg, "Onboard_Temp_DegC", APP_SENSORS_readTemperature());